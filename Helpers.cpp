@@ -5,28 +5,94 @@
 #include <algorithm>
 #include <filesystem.>
 #include <time.h>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <climits>
 
 
 using namespace Eigen;
 using namespace std;
 
-float INV_RAND_MAX = 1.0 / (float)RAND_MAX;
+uint64_t RNG_seed = 0;
+const uint64_t THREAD_STREAMS = 1ull << 63; // Streams of threads that have not chosen a stream
+std::atomic<uint64_t> next_thread_stream = 1;
+thread_local fessga::RandomStream thread_stream;
+thread_local bool thread_stream_initialized = false;
 
-void fessga::help::init_RNG() {
-    srand(time(NULL));
-    int x = rand();
-    int z = x * 3;
+// Advance the given SplitMix64 state and return its next output
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void fessga::RandomStream::reset(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed;
+    x = splitmix64(x) ^ stream;
+    for (int i = 0; i < 4; i++) state[i] = splitmix64(x);
+}
+
+uint64_t fessga::RandomStream::next() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+void fessga::help::init_RNG(uint64_t seed) {
+    if (seed == 0) {
+        uint64_t x = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count() ^ (uint64_t)time(NULL);
+        seed = splitmix64(x);
+    }
+    RNG_seed = seed;
+    next_thread_stream = 1;
+    set_rand_stream(0);
+}
+
+uint64_t fessga::help::get_RNG_seed() {
+    return RNG_seed;
+}
+
+void fessga::help::set_rand_stream(uint64_t stream) {
+    thread_stream.reset(RNG_seed, stream);
+    thread_stream_initialized = true;
+}
+
+fessga::RandomStream& fessga::help::get_rand_stream() {
+    if (!thread_stream_initialized) set_rand_stream(THREAD_STREAMS | next_thread_stream++);
+    return thread_stream;
 }
 
 float fessga::help::get_rand_float(float min, float max) {
-    return min + (float)rand() * INV_RAND_MAX * (max - min);
+    return min + get_rand_stream().next_float() * (max - min);
 }
 
 uint fessga::help::get_rand_uint(float min, float max) {
-    float float_rand_range = (float)rand() * INV_RAND_MAX * (max - min);
+    float float_rand_range = get_rand_stream().next_float() * (max - min);
     return round(min + float_rand_range);
 }
 
+int fessga::help::get_rand_skip(double log_1_minus_p) {
+    double u = 1.0 - get_rand_stream().next_double(); // Uniform in (0, 1]
+    double skip = floor(log(u) / log_1_minus_p);
+    return skip < (double)(INT_MAX / 2) ? (int)skip : INT_MAX / 2; // Capped so that adding the skip to an index cannot overflow
+}
+
+uint64_t fessga::help::get_rand_bits() {
+    return get_rand_stream().next();
+}
+
 bool fessga::help::is_in(std::vector<int>* vec, int item) {
     return find(vec->begin(), vec->end(), item) != vec->end();
 }
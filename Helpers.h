@@ -4,6 +4,7 @@
 #include <map>
 #include <cstdlib>
 #include <set>
+#include <cstdint>
 #include <Windows.h>
 
 #define VERBOSE false
@@ -32,11 +33,36 @@ typedef std::set < std::pair<int, double>, _comparator> PairSet;
 
 namespace fessga {
 
+	/*
+	xoshiro256** pseudo-random number generator. Its state is seeded through SplitMix64, so that every (seed, stream) pair
+	yields an independent, well-mixed sequence.
+	*/
+	class RandomStream {
+	public:
+		RandomStream(uint64_t seed = 0, uint64_t stream = 0) { reset(seed, stream); }
+		void reset(uint64_t seed, uint64_t stream);
+		uint64_t next();
+		float next_float() { return (float)(next() >> 40) * 0x1.0p-24f; } // Uniform in [0, 1)
+		double next_double() { return (double)(next() >> 11) * 0x1.0p-53; } // Uniform in [0, 1)
+	private:
+		uint64_t state[4];
+	};
+
 	class help
 	{
 	public:
 
-		static void init_RNG();
+		// Set the run seed from which all random streams are derived (see get_rand_stream), and reset the calling thread to
+		// stream 0. If no seed is given, one is derived from the clock. Runs with the same seed can be replayed exactly.
+		static void init_RNG(uint64_t seed = 0);
+
+		static uint64_t get_RNG_seed();
+
+		// Switch the calling thread to the given stream of the run seed. Threads that have not chosen a stream draw from
+		// a stream of their own.
+		static void set_rand_stream(uint64_t stream);
+
+		static RandomStream& get_rand_stream();
 
 		static double max(double val1, double val2);
 
@@ -87,6 +113,13 @@ namespace fessga {
 
 		static uint get_rand_uint(float min, float max);
 
+		// Draw the number of failures before the next success of a sequence of Bernoulli trials with success probability p,
+		// given log(1 - p). Skipping over these gaps selects the same trials as testing each trial, with one draw per success.
+		static int get_rand_skip(double log_1_minus_p);
+
+		// Draw 64 uniformly random bits
+		static uint64_t get_rand_bits();
+
 		static void remove(vector<int>* vec, int item);
 
 		static std::string add_padding(std::string basestring, int version);
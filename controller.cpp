@@ -63,6 +63,7 @@ void Controller::do_static_setup(phys::FEACaseManager& fea_casemanager) {
     };
     msh::init_fea_cases(&fea_casemanager, case_folder, case_names, &densities2d, &mesh);
     fea_casemanager.initialize();
+    fea_casemanager.results_format = "vtk"; // "vtk" (legacy ASCII) or "vtu" (appended raw binary)
     if (fea_casemanager.mechanical_constraint == "Displacement") {
         int visited_x = 0;
         for (auto& bound_cell : fea_casemanager.keep_cells) {
@@ -89,16 +90,42 @@ void Controller::run_fess(FESS& _fess) {
     float greediness = 0.2;
     bool do_feasibility_filtering = true;
     bool verbose = true;
+    bool incremental_reanalysis = false;
+    float max_update_fraction = 0.02;
 
     // Run optimization
     FESS fess = FESS(
         fea_casemanager, mesh, base_folder, min_stress, densities2d, max_iterations, greediness,
-        do_feasibility_filtering, export_msh, verbose
+        do_feasibility_filtering, export_msh, verbose, incremental_reanalysis, max_update_fraction
     );
     _fess = fess;
     fess.run();
 }
 
+void Controller::run_simp(SIMP& _simp) {
+    phys::FEACaseManager fea_casemanager;
+    do_static_setup(fea_casemanager);
+
+    // Parameters
+    fea_casemanager.max_stress_threshold = max_stress;
+    fea_casemanager.maintain_boundary_connection = true;
+    bool export_msh = false;
+    bool verbose = true;
+    float volume_step = 0.05;
+    double penalty = 3.0;
+    double filter_radius = 1.5;
+    double move_limit = 0.2;
+    double convergence_tolerance = 0.01;
+
+    // Run optimization
+    SIMP simp = SIMP(
+        fea_casemanager, mesh, base_folder, densities2d, max_iterations, volume_step, penalty, filter_radius,
+        move_limit, convergence_tolerance, export_msh, verbose
+    );
+    _simp = simp;
+    simp.run();
+}
+
 void Controller::run_emma_static(Evolver& _evolver) {
     phys::FEACaseManager fea_casemanager;
     do_static_setup(fea_casemanager);
@@ -177,7 +204,7 @@ void Controller::run_emma(Evolver& _evolver, phys::FEACaseManager* fea_casemanag
     fea_casemanager->max_stress_threshold = max_stress;
 
     // Evolver-specific parameters
-    string crossover_method = "2x";
+    string crossover_method = "2x"; // "2x" (2-point), "ux" (uniform), "block" or "spatial" (rectangle or circle patch)
     float initial_perturb_level0 = 0.2;
     float initial_perturb_level1 = 0.02;
     int pop_size = 12; // NOTE: must be >10 and divisible by 6
@@ -186,17 +213,104 @@ void Controller::run_emma(Evolver& _evolver, phys::FEACaseManager* fea_casemanag
     int max_iterations_without_change = 150;
     float variation_trigger = 1.5;
     int no_static_iterations_trigger = 6;
+    string mutation_method = "uniform"; // "uniform" or "sensitivity" (requires in-process FEA)
+
+    EvaluationOptions evaluation;
+    evaluation.in_process_fea = false;
+    evaluation.no_threads = input.no_threads;
+    evaluation.max_solver_processes = 0; // 0 uses half the hardware threads
+    evaluation.archive_results = false; // Record evaluated individuals in per-iteration archives instead of keeping their folders (see action 'extract_archive')
+    evaluation.superposition_mode = "background"; // Write superpositions of new best individuals "background" or at the "end" of the run
+
+    ScreeningOptions screening;
+    screening.fraction = 1.0; // Fraction of children sent to full FEA (1.0 disables pre-screening)
+    screening.audit_size = 1;
+
+    FidelityOptions fidelity;
+    fidelity.no_levels = 1; // Number of grid resolutions to evolve on, starting at dim_x / 2^(no_levels - 1)
+    fidelity.refinement_trigger = 0.001;
+
+    CacheOptions cache;
+    cache.size = 0; // Maximum number of cached FEA results (0 disables the cache)
+    cache.file = ""; // If set, cached FEA results are loaded from and saved to this file
+
+    SteadyStateOptions steady_state;
+    steady_state.evolution_mode = "generational"; // "generational" or "steady-state" (children replace individuals as soon as they are evaluated)
+    steady_state.replacement_method = "worst"; // Steady-state replacement of the "worst" individual, or the loser of a "tournament"
+
+    IslandOptions islands;
+    islands.migration_interval = 10; // Number of iterations between migrations of individuals between islands
+    islands.no_migrants = 2;
+    islands.base_port = 50000;
+    islands.hosts = input.island_hosts;
+
+    // Islands on the same machine share its hardware threads, and each writes to its own output folder
+    string evolver_folder = base_folder;
+    if (input.no_islands > 1) {
+        if (evaluation.no_threads == 0) evaluation.no_threads = max(1, (int)thread::hardware_concurrency() / input.no_islands);
+        evolver_folder = IO::create_folder_if_not_exists(base_folder + "/island_" + to_string(input.island + 1));
+    }
 
     // Initialize and run evolver
     Evolver evolver(
-        *fea_casemanager, mesh, base_folder, pop_size, no_static_iterations_trigger, mutation_rate_level0,
+        *fea_casemanager, mesh, evolver_folder, pop_size, no_static_iterations_trigger, mutation_rate_level0,
         mutation_rate_level1, densities2d, variation_trigger, max_iterations, max_iterations_without_change,
-        export_msh, verbose, initial_perturb_level0, initial_perturb_level1, crossover_method, stress_fitness_influence
+        export_msh, verbose, initial_perturb_level0, initial_perturb_level1, crossover_method, stress_fitness_influence,
+        mutation_method, evaluation, screening, fidelity, cache, steady_state
     );
+    if (input.no_islands > 1) evolver.join_islands(input.island, input.no_islands, islands);
     _evolver = evolver;
     evolver.evolve();
 }
 
+// Recreate the Elmer case (FE mesh, case files, density distribution and batch file) and the .vtk results of archived
+// individuals, each in a folder named after the record, next to the archive
+void Controller::extract_archive() {
+    phys::FEACaseManager fea_casemanager;
+    do_static_setup(fea_casemanager);
+    phys::ResultsArchive archive;
+    if (!archive.open(input.archive_path)) return;
+    string extraction_folder = IO::create_folder_if_not_exists(help::replace_occurrences(input.archive_path, ".bin", ""));
+    vector<int> records;
+    for (int i = 0; i < archive.size(); i++) {
+        if (input.archive_record == "" || archive.names[i] == input.archive_record) records.push_back(i);
+    }
+    if (records.empty()) cout << "Controller: ERROR: Archive " << input.archive_path << " has no record '" << input.archive_record << "'\n";
+
+    for (auto& i : records) {
+        phys::ResultsArchive::Record record;
+        if (!archive.read(i, record)) {
+            cout << "Controller: ERROR: Unable to read record " << archive.names[i] << " from archive.\n";
+            continue;
+        }
+        if (record.dim_x != densities2d.dim_x || record.dim_y != densities2d.dim_y) {
+            cout << "Controller: Skipping record " << record.name << ", which was evaluated at a different resolution ("
+                << record.dim_x << " x " << record.dim_y << " cells).\n";
+            continue;
+        }
+        grd::Densities2d individual(&densities2d);
+        individual.fea_casemanager = &fea_casemanager;
+        individual.output_folder = IO::create_folder_if_not_exists(extraction_folder + "/" + record.name);
+        for (int cell = 0; cell < individual.size; cell++) individual.set(cell, record.get_density(cell));
+        individual.update_count();
+
+        msh::FEMesh2D fe_mesh;
+        msh::create_FE_mesh(mesh, individual, fe_mesh);
+        msh::export_as_elmer_files(&fe_mesh, individual.output_folder);
+        OptimizerBase::create_sif_files(&individual, &fe_mesh);
+        individual.do_export(individual.output_folder + "/distribution2d.dens");
+        msh::create_batch_file(individual.output_folder);
+        for (int c = 0; c < record.case_fields.size() && c < archive.case_names.size(); c++) {
+            msh::export_nodal_field_as_vtk(
+                &fe_mesh, archive.mechanical_constraint, &record.case_fields[c],
+                individual.output_folder + "/" + archive.case_names[c] + "_0001.vtk"
+            );
+        }
+        individual.delete_arrays();
+        cout << "Extracted " << record.name << " (fitness " << record.fitness << ") to " << individual.output_folder << endl;
+    }
+}
+
 void Controller::run_emma_dynamic() {
     Evolver evolver;
     run_emma_dynamic(evolver);
@@ -210,4 +324,9 @@ void Controller::run_emma_static() {
 void Controller::run_fess() {
     FESS fess;
     run_fess(fess);
+}
+
+void Controller::run_simp() {
+    SIMP simp;
+    run_simp(simp);
 }
\ No newline at end of file
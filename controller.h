@@ -8,6 +8,7 @@
 #include "gui.h"
 #include "evolver.h"
 #include "fess.h"
+#include "simp.h"
 
 
 struct Input {
@@ -18,6 +19,13 @@ struct Input {
     string name;
     float size, stress_fitness_influence;
     string mechanical_constraint;
+    string archive_path; // Results archive to extract from (action 'extract_archive')
+    string archive_record; // Name of the record to extract. If empty, all records are extracted.
+    int no_threads = 0; // Number of worker threads used for FEA (action 'evolve'). 0 uses all hardware threads.
+    int island = 0; // Index of this process in a ring of evolver islands (action 'evolve', see Evolver::join_islands)
+    int no_islands = 1;
+    vector<string> island_hosts; // Host of each island. If empty, all islands run on localhost.
+    uint64_t seed = 0; // Run seed (see help::init_RNG). 0 derives a seed from the clock.
 };
 
 class Controller {
@@ -37,7 +45,7 @@ public:
         stress_fitness_influence = input.stress_fitness_influence;
 
         // Initialize RNG
-        help::init_RNG();
+        help::init_RNG(input.seed);
 
         // Load mesh
         MatrixXd V;
@@ -86,11 +94,17 @@ public:
         else if (action == "fess") {
             run_fess();
         }
+        else if (action == "simp") {
+            run_simp();
+        }
         else if (action == "export_distribution") {
             init_densities();
             string densities_file = densities2d.do_export(base_folder + "/distribution2d.dens");
             cout << "Exported density distribution to " << densities_file << endl;
         }
+        else if (action == "extract_archive") {
+            extract_archive();
+        }
         else if (action == "test") cout << "Test mode; controller remains passive." << endl;
         else {
             cerr << "Error: Action '" << action << "' not recognized.\n" << endl;
@@ -99,12 +113,15 @@ public:
     void init_densities(phys::FEACaseManager* fea_casemanager = 0);
     void run_fess(FESS& _fess);
     void run_fess();
+    void run_simp(SIMP& _simp);
+    void run_simp();
     void run_emma_dynamic(Evolver& _evolver);
     void run_emma_dynamic();
     void run_emma_static(Evolver& _evolver);
     void run_emma_static();
     void run_emma(Evolver& _evolver, phys::FEACaseManager* fea_manager);
     void do_static_setup(phys::FEACaseManager& fea_casemanager);
+    void extract_archive();
 
     vector<MatrixXd> V_list;
     vector<MatrixXi> F_list;
@@ -48,7 +48,7 @@ string fessga::grd::Densities2d::do_export(string output_path) {
 void fessga::grd::Densities2d::init_vtk_paths() {
     vtk_paths.clear();
     for (auto& fea_case : fea_casemanager->active_cases) {
-        vtk_paths.push_back(output_folder + "/" + fea_case.name + "_0001.vtk");
+        vtk_paths.push_back(output_folder + "/" + fea_casemanager->get_results_filename(fea_case.name));
     }
 }
 
@@ -413,7 +413,11 @@ int fessga::grd::Densities2d::remove_low_stress_cells(
     int cell_from_smaller_piece;
     int no_iterations_without_removal = -1;
     int initial_count = count();
-    for (auto [cell, cell_stress] : fea_results.data) {
+
+    // Only cells that do not exceed the maximum stress are candidates for removal, so only those need to be ordered.
+    vector<int> candidate_cells;
+    fea_results.get_sorted_cells(candidate_cells, fea_casemanager->max_stress_threshold);
+    for (int cell : candidate_cells) {
         no_iterations_without_removal++;
         if (no_iterations_without_removal > 200) {
             if (true) cout << "WARNING: 200 cells in a row could not be removed. "
@@ -421,10 +425,6 @@ int fessga::grd::Densities2d::remove_low_stress_cells(
             return removed_cells.size();
         }
 
-        // If the cell's stress exceeds the maximum, break the loop (all subsequent cells will also exceed the
-        // maximum since the list is ordered).
-        if (cell_stress > fea_casemanager->max_stress_threshold) break;
-
         //if (no_iterations_without_removal > 100) cout << "before boundcells\n";
         
         // If the cell has a line on which a boundary condition was applied, skip deletion
@@ -507,7 +507,7 @@ bool fessga::grd::Densities2d::remove_floating_piece(
         // TODO: The last two conditions of the following if-statement should not be necessary, but they are.
         // Figure out why.
         bool cell_cannot_be_removed = (
-            fea_results.data_map[cell] > fea_casemanager->max_stress_threshold ||
+            fea_results.get(cell) > fea_casemanager->max_stress_threshold ||
             help::is_in(&fea_casemanager->keep_cells, cell)
         );
         if (cell_cannot_be_removed) {
@@ -905,6 +905,78 @@ void fessga::grd::Densities2d::copy_to(uint* target) {
     for (int i = 0; i < size; i++) target[i] = values[i];
 }
 
+// Pack the density values into the given vector, 64 cells per word. Cell i is stored in bit (i % 64) of word (i / 64).
+void fessga::grd::Densities2d::pack(vector<uint64_t>& words) {
+    words.assign((size + 63) / 64, 0);
+    for (int i = 0; i < size; i++) words[i >> 6] |= (uint64_t)(values[i] & 1) << (i & 63);
+}
+
+// Set the density values from the given packed words (see pack) and recount them
+void fessga::grd::Densities2d::unpack(vector<uint64_t>* words) {
+    _count = 0;
+    for (int i = 0; i < size; i++) {
+        values[i] = (words->at(i >> 6) >> (i & 63)) & 1;
+        _count += values[i];
+    }
+}
+
+// Resample the density values onto the grid of the given Densities2d-object, which covers the same domain at a different
+// resolution. When downsampling, a target cell is filled if at least half of the source cells whose centers it contains are
+// filled. Target cells that contain no source cell centers (when upsampling) take the value of the source cell containing
+// their own center.
+void fessga::grd::Densities2d::resample_to(Densities2d* target) {
+    vector<int> no_filled(target->size, 0), no_sources(target->size, 0);
+    double ratio_x = (double)target->dim_x / (double)dim_x;
+    double ratio_y = (double)target->dim_y / (double)dim_y;
+    for (int x = 0; x < dim_x; x++) {
+        for (int y = 0; y < dim_y; y++) {
+            int target_x = min((int)(((double)x + 0.5) * ratio_x), target->dim_x - 1);
+            int target_y = min((int)(((double)y + 0.5) * ratio_y), target->dim_y - 1);
+            int target_cell = target->get_idx(target_x, target_y);
+            no_sources[target_cell]++;
+            no_filled[target_cell] += values[get_idx(x, y)];
+        }
+    }
+    for (int x = 0; x < target->dim_x; x++) {
+        for (int y = 0; y < target->dim_y; y++) {
+            int target_cell = target->get_idx(x, y);
+            if (no_sources[target_cell]) {
+                target->set(target_cell, no_filled[target_cell] * 2 >= no_sources[target_cell]);
+                continue;
+            }
+            int source_x = min((int)(((double)x + 0.5) / ratio_x), dim_x - 1);
+            int source_y = min((int)(((double)y + 0.5) / ratio_y), dim_y - 1);
+            target->set(target_cell, values[get_idx(source_x, source_y)]);
+        }
+    }
+    target->redo_count();
+}
+
+// Get the cells of a differently sized grid covering the same domain that correspond to the given cell. These are the target
+// cells whose centers lie inside the given cell. The target cell that contains the given cell's center is always included, 
+// and is the first element of the resulting vector.
+void fessga::grd::Densities2d::get_resampled_cells(
+    int cell, int source_dim_x, int source_dim_y, int target_dim_x, int target_dim_y, vector<int>& target_cells
+) {
+    double ratio_x = (double)target_dim_x / (double)source_dim_x;
+    double ratio_y = (double)target_dim_y / (double)source_dim_y;
+    int x = cell / source_dim_y;
+    int y = cell % source_dim_y;
+    int center_x = min((int)(((double)x + 0.5) * ratio_x), target_dim_x - 1);
+    int center_y = min((int)(((double)y + 0.5) * ratio_y), target_dim_y - 1);
+    target_cells.push_back(center_x * target_dim_y + center_y);
+    for (int target_x = (int)(x * ratio_x); target_x < min((int)ceil((x + 1) * ratio_x), target_dim_x); target_x++) {
+        double source_center_x = ((double)target_x + 0.5) / ratio_x;
+        if (source_center_x < x || source_center_x >= x + 1) continue;
+        for (int target_y = (int)(y * ratio_y); target_y < min((int)ceil((y + 1) * ratio_y), target_dim_y); target_y++) {
+            double source_center_y = ((double)target_y + 0.5) / ratio_y;
+            if (source_center_y < y || source_center_y >= y + 1) continue;
+            int target_cell = target_x * target_dim_y + target_y;
+            if (target_cell != target_cells[0]) target_cells.push_back(target_cell);
+        }
+    }
+}
+
 // Copy the density values from one array to another
 void fessga::grd::Densities2d::copy(uint* source, uint* target, int source_count, int target_count) {
     for (int i = 0; i < size; i++) target[i] = source[i];
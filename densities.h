@@ -124,6 +124,7 @@ namespace fessga {
                 _count = -2;
                 values[cell] = value;
             }
+            uint* get_values() { return values; }
             void replace_values(uint* values_ptr) {
                 values = values_ptr;
                 redo_count();
@@ -231,6 +232,12 @@ namespace fessga {
             void remove_smaller_pieces();
             void copy_from(Densities2d* source);
             void copy_to(uint* target);
+            void pack(vector<uint64_t>& words);
+            void unpack(vector<uint64_t>* words);
+            void resample_to(Densities2d* target);
+            static void get_resampled_cells(
+                int cell, int source_dim_x, int source_dim_y, int target_dim_x, int target_dim_y, vector<int>& target_cells
+            );
             void do_import(string path, float width);
             void filter(int no_neighbors = 0, bool restore_bound_cells = false);
             void init_pieces(int _start_cell = -1);
@@ -0,0 +1,155 @@
+#pragma once
+#include "diversity.h"
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+#ifdef _MSC_VER
+int popcount64(uint64_t word) { return (int)__popcnt64(word); }
+int count_trailing_zeros(uint64_t word) {
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return index;
+}
+#else
+int popcount64(uint64_t word) { return __builtin_popcountll(word); }
+int count_trailing_zeros(uint64_t word) { return __builtin_ctzll(word); }
+#endif
+
+// SplitMix64 finalizer, used to hash cell indices for the MinHash sketches
+uint64_t hash_cell(uint64_t cell) {
+	uint64_t z = cell + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+PackedPopulation::PackedPopulation(vector<evo::Individual2d>* population) {
+	if (population->empty()) return;
+	no_cells = population->at(0).size;
+	no_words = (no_cells + 63) / 64;
+	words.reserve((size_t)population->size() * no_words);
+	vector<uint64_t> individual_words;
+	for (auto& individual : *population) {
+		individual.pack(individual_words);
+		words.insert(words.end(), individual_words.begin(), individual_words.end());
+		int count = 0;
+		for (auto& word : individual_words) count += popcount64(word);
+		counts.push_back(count);
+	}
+}
+
+// Get the number of cells in which the given individuals differ
+int PackedPopulation::get_distance(int individual1, int individual2) const {
+	const uint64_t* words1 = get_words(individual1);
+	const uint64_t* words2 = get_words(individual2);
+	int distance = 0;
+	for (int word = 0; word < no_words; word++) distance += popcount64(words1[word] ^ words2[word]);
+	return distance;
+}
+
+// Get the distances between all pairs of individuals. Intended for small populations, since the cost is quadratic.
+vector<vector<int>> PackedPopulation::get_distance_matrix() const {
+	vector<vector<int>> distances(size(), vector<int>(size(), 0));
+	for (int i = 0; i < size(); i++) {
+		for (int j = i + 1; j < size(); j++) {
+			distances[i][j] = get_distance(i, j);
+			distances[j][i] = distances[i][j];
+		}
+	}
+	return distances;
+}
+
+/*
+Get the mean distance of each individual to the other individuals. If <no_samples> is positive and smaller than the
+number of other individuals, the mean is estimated from the distances to <no_samples> randomly chosen others.
+*/
+vector<double> PackedPopulation::get_mean_distances(int no_samples) const {
+	vector<double> mean_distances(size(), 0);
+	if (size() < 2) return mean_distances;
+	if (no_samples <= 0 || no_samples >= size() - 1) {
+		for (int i = 0; i < size(); i++) {
+			for (int j = i + 1; j < size(); j++) {
+				int distance = get_distance(i, j);
+				mean_distances[i] += distance;
+				mean_distances[j] += distance;
+			}
+		}
+		for (auto& mean_distance : mean_distances) mean_distance /= (double)(size() - 1);
+		return mean_distances;
+	}
+	for (int i = 0; i < size(); i++) {
+		for (int sample = 0; sample < no_samples; sample++) {
+			int other = fessga::help::get_rand_uint(0, size() - 2);
+			if (other >= i) other++;
+			mean_distances[i] += get_distance(i, other);
+		}
+		mean_distances[i] /= (double)no_samples;
+	}
+	return mean_distances;
+}
+
+/*
+Get the MinHash sketch of the given individual's filled cells, using one-permutation hashing: each filled cell is hashed
+once, the hash selects one of <no_bins> bins, and each bin keeps the smallest hash it received. Empty bins hold the
+maximum value.
+*/
+vector<uint64_t> PackedPopulation::get_minhash_sketch(int individual, int no_bins) const {
+	vector<uint64_t> sketch(no_bins, numeric_limits<uint64_t>::max());
+	const uint64_t* individual_words = get_words(individual);
+	for (int word = 0; word < no_words; word++) {
+		for (uint64_t bits = individual_words[word]; bits != 0; bits &= bits - 1) {
+			uint64_t hash = hash_cell((uint64_t)word * 64 + count_trailing_zeros(bits));
+			uint64_t& bin = sketch[hash % no_bins];
+			bin = min(bin, hash);
+		}
+	}
+	return sketch;
+}
+
+/*
+Estimate the mean distance of each individual to the other individuals from MinHash sketches. The fraction of matching
+bins estimates the Jaccard similarity J of two individuals' filled cells, from which their distance follows as
+(|A| + |B|)(1 - J) / (1 + J). Comparing sketches costs <no_bins> per pair, independent of the grid size.
+*/
+vector<double> PackedPopulation::get_sketched_mean_distances(int no_bins) const {
+	vector<double> mean_distances(size(), 0);
+	if (size() < 2) return mean_distances;
+	vector<vector<uint64_t>> sketches;
+	for (int i = 0; i < size(); i++) sketches.push_back(get_minhash_sketch(i, no_bins));
+	const uint64_t empty = numeric_limits<uint64_t>::max();
+	for (int i = 0; i < size(); i++) {
+		for (int j = i + 1; j < size(); j++) {
+			int no_matches = 0, no_nonempty = 0;
+			for (int bin = 0; bin < no_bins; bin++) {
+				if (sketches[i][bin] == empty && sketches[j][bin] == empty) continue;
+				no_nonempty++;
+				no_matches += sketches[i][bin] == sketches[j][bin];
+			}
+			double similarity = no_nonempty > 0 ? (double)no_matches / (double)no_nonempty : 1.0;
+			double distance = (double)(counts[i] + counts[j]) * (1.0 - similarity) / (1.0 + similarity);
+			mean_distances[i] += distance;
+			mean_distances[j] += distance;
+		}
+	}
+	for (auto& mean_distance : mean_distances) mean_distance /= (double)(size() - 1);
+	return mean_distances;
+}
+
+// Get the fraction of individuals in which each cell is filled
+vector<float> PackedPopulation::get_consensus_frequencies() const {
+	vector<int> no_filled(no_cells, 0);
+	for (int i = 0; i < size(); i++) {
+		const uint64_t* individual_words = get_words(i);
+		for (int word = 0; word < no_words; word++) {
+			for (uint64_t bits = individual_words[word]; bits != 0; bits &= bits - 1) {
+				no_filled[word * 64 + count_trailing_zeros(bits)]++;
+			}
+		}
+	}
+	vector<float> frequencies(no_cells, 0);
+	for (int cell = 0; cell < no_cells; cell++) frequencies[cell] = (float)no_filled[cell] / (float)max(1, size());
+	return frequencies;
+}
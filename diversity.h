@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "individual.h"
+
+using namespace std;
+
+
+/*
+Density distributions of a population packed into 64-bit words (see grd::Densities2d::pack), stored contiguously. The
+Hamming distance between two individuals is the popcount of the XOR of their words, so that distances are computed 64
+cells at a time. For populations too large for all pairwise distances, the mean distances can be estimated from a sample
+of pairs, or from MinHash sketches of the individuals' filled cells.
+*/
+class PackedPopulation {
+public:
+	PackedPopulation() = default;
+	PackedPopulation(vector<evo::Individual2d>* population);
+	int size() const { return counts.size(); }
+	int get_count(int individual) const { return counts[individual]; }
+	int get_distance(int individual1, int individual2) const;
+	vector<vector<int>> get_distance_matrix() const;
+	vector<double> get_mean_distances(int no_samples = 0) const;
+	vector<double> get_sketched_mean_distances(int no_bins = 64) const;
+	vector<uint64_t> get_minhash_sketch(int individual, int no_bins) const;
+	vector<float> get_consensus_frequencies() const;
+	int no_cells = 0;
+	int no_words = 0;
+private:
+	const uint64_t* get_words(int individual) const { return words.data() + (size_t)individual * no_words; }
+	vector<uint64_t> words;
+	vector<int> counts; // Number of filled cells of each individual
+};
@@ -7,126 +7,182 @@
 //#define UNIFORM_POPULATION
 //#define FEA_IGNORE
 
-int NO_FEA_THREADS = 6; // must be even number
-int NO_RESULTS_THREADS = 2; // must be even number
 
+void SuperpositionQueue::push(phys::SuperpositionReference reference) {
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		pending.push_back(reference);
+	}
+	queue_condition.notify_one();
+}
 
-/*
-* Method to run a batch of FEA jobs on all given output folders
-*/
-void run_FEA_batch(
-	vector<string> individual_folders, phys::FEACaseManager* fea_casemanager, int pop_size, int thread_offset, bool verbose
-) {
-	cout << "Starting FEA batch thread " + to_string(thread_offset + 1) + "\n";
-	// Run FEA on all individuals in the population that have not yet been evaluated (usually only the newly generated children)
-	int i = 0;
-	bool is_2nd_attempt = false;
-	for (int i = thread_offset; i < pop_size; i += NO_FEA_THREADS) {
-		string elmer_bat_file = individual_folders[i] + "/run_elmer.bat";
-		while (!IO::file_exists(elmer_bat_file)) {} // Wait for elmer batfile to appear on disk
-		fessga::phys::call_elmer(individual_folders[i], fea_casemanager);
-		
-		// Get vtk paths
-		vector<string> vtk_paths;
-		msh::get_vtk_paths(fea_casemanager, individual_folders[i], vtk_paths);
-
-		// Wait for all case files to appear on disk
-		time_t start = time(0);
-		bool fea_failed = false;
-		for (auto& vtk_path : vtk_paths) {
-			while (!IO::file_exists(vtk_path)) {
-				float seconds_since_start = difftime(time(0), start);
-				if (seconds_since_start > 10) {
-					// If the vtk file has not appeared after 10 seconds, retry running the elmer batchfile (once).
-					fea_failed = true;
-					if (!is_2nd_attempt) {
-						cout << "- WARNING:   First attempt to produce a vtk file failed on case '" << vtk_path << "'\n";
-					}
-					else {
-						cout << "- ERROR:   Second attempt to produce a vtk file failed on case '" << vtk_path << "'\n";
-					}
-					break;
-				}
-			}
-			if (fea_failed) break;
-		}
-		if (fea_failed) {
-			if (is_2nd_attempt) { // After two attempts to run the FEA, signal that FEA has failed by creating a file 'FEA_FAILED.txt'.
-				IO::write_text_to_file(" ", individual_folders[i] + "/FEA_FAILED.txt");
-				is_2nd_attempt = false;
-				continue;
-			}
-			cout << "Re-running Elmer bat file in individual folder '" << individual_folders[i] << "'\n";
-			i -= NO_FEA_THREADS;
-			is_2nd_attempt = true;
-			continue;
+bool SuperpositionQueue::pop(phys::SuperpositionReference& reference) {
+	lock_guard<mutex> lock(queue_mutex);
+	if (pending.empty()) return false;
+	reference = pending.front();
+	pending.pop_front();
+	return true;
+}
+
+int SuperpositionQueue::size() {
+	lock_guard<mutex> lock(queue_mutex);
+	return pending.size();
+}
+
+void SuperpositionQueue::start() {
+	if (worker.joinable()) return;
+	stopping = false;
+	worker = thread(&SuperpositionQueue::work, this);
+}
+
+// Stop the background thread once it has finished the superposition it is currently writing. Pending superpositions remain queued.
+void SuperpositionQueue::stop() {
+	if (!worker.joinable()) return;
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		stopping = true;
+	}
+	queue_condition.notify_one();
+	worker.join();
+}
+
+// Write all pending superpositions on the calling thread
+void SuperpositionQueue::flush() {
+	phys::SuperpositionReference reference;
+	while (pop(reference)) phys::write_results_superposition(&reference);
+}
+
+void SuperpositionQueue::work() {
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+	while (true) {
+		phys::SuperpositionReference reference;
+		{
+			unique_lock<mutex> lock(queue_mutex);
+			queue_condition.wait(lock, [this] { return stopping || !pending.empty(); });
+			if (stopping) return;
+			reference = pending.front();
+			pending.pop_front();
 		}
-		is_2nd_attempt = false;
+		phys::write_results_superposition(&reference);
+	}
+}
 
-		// Communicate that FEA is finished and that the .vtk file is therefore ready to be read.
-		IO::write_text_to_file(" ", individual_folders[i] + "/FEA_FINISHED.txt");
-		if (i == pop_size - 1) cout << "About to finish FEA for all children.\n";
-		
-		// Log progress to stdout
-		if (verbose && (pop_size < 10 || (i + 1) % (pop_size / 5) == 0))
-			cout << "- Finished FEA for individual " << i + 1 << " / " << pop_size << "\n";
+// Seconds elapsed since the given time point
+double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Admit an individual into the pipeline, blocking while the pipeline is full
+void EvaluationPipeline::enter() {
+	auto start = chrono::steady_clock::now();
+	unique_lock<mutex> lock(pipeline_mutex);
+	pipeline_condition.wait(lock, [this] { return no_in_flight < capacity; });
+	no_in_flight++;
+	stall_time += seconds_since(start);
+}
+
+// Release an individual from the pipeline once its results have been loaded
+void EvaluationPipeline::leave() {
+	{
+		lock_guard<mutex> lock(pipeline_mutex);
+		no_in_flight--;
+	}
+	pipeline_condition.notify_one();
+}
+
+void EvaluationPipeline::record(Stage stage, double seconds, int count) {
+	lock_guard<mutex> lock(pipeline_mutex);
+	busy_time[stage] += seconds;
+	no_processed[stage] += count;
+}
+
+// Get the number of individuals (or FEA cases, for the solve stage) the given stage processed per second of work
+double EvaluationPipeline::get_throughput(Stage stage) {
+	lock_guard<mutex> lock(pipeline_mutex);
+	return busy_time[stage] > 0 ? (double)no_processed[stage] / busy_time[stage] : 0;
+}
+
+double EvaluationPipeline::get_stall_time() {
+	lock_guard<mutex> lock(pipeline_mutex);
+	return stall_time;
+}
+
+void EvaluationPipeline::reset_stats() {
+	lock_guard<mutex> lock(pipeline_mutex);
+	for (int i = 0; i < NO_STAGES; i++) {
+		busy_time[i] = 0;
+		no_processed[i] = 0;
+	}
+	stall_time = 0;
+}
+
+
+/*
+Run the given step of an individual's evaluation on the worker pool. Exceptions (e.g. from parsing a malformed results
+file, or running out of memory) are reported and turn the step into a failure, so that a single faulty individual does
+not end the run.
+*/
+bool try_evaluation_step(string step_name, string folder, function<void()> step) {
+	try {
+		step();
+		return true;
+	}
+	catch (const exception& e) {
+		cout << "- ERROR:   " << step_name << " failed for individual in " << folder << ": " << e.what() << endl;
+	}
+	catch (const char* message) {
+		cout << "- ERROR:   " << step_name << " failed for individual in " << folder << ": " << message << endl;
 	}
+	catch (...) {
+		cout << "- ERROR:   " << step_name << " failed for individual in " << folder << ".\n";
+	}
+	return false;
 }
 
-// Obtain FEA results
-void load_physics_batch(
-	vector<evo::Individual2d>* population, int pop_offset, int thread_offset, int pop_size,
-	msh::SurfaceMesh* mesh, bool verbose = true
+// Run Elmer on the given FEA case of the individual in <folder> (see phys::solve_elmer_case). The number of concurrent
+// Elmer processes is limited by <solver_processes>.
+bool run_FEA_case(
+	string folder, string case_name, phys::FEACaseManager* fea_casemanager, phys::RetryPolicy retry_policy,
+	ProcessLimiter* solver_processes
 ) {
-	for (int i = pop_offset + thread_offset; i < (pop_offset + pop_size); i += NO_RESULTS_THREADS) {
-		// Wait for the 'FEA_FINISHED.txt' file to appear, which indicates the .vtk files are ready.
-		string fea_finish_confirmation_file = population->at(i).output_folder + "/FEA_FINISHED.txt";
-		string fea_failed_confirmation_file = population->at(i).output_folder + "/FEA_FAILED.txt";
-		bool fea_failed = false;
-		time_t start = time(0);
-		while (!IO::file_exists(fea_finish_confirmation_file)) {
-			if ((time(0) - start) > 20) {
-				cout << "WARNING: FEA Loader " << thread_offset << " is not finding FEA confirmation file (" << fea_finish_confirmation_file << ")... This may be a bug.\n";
-				start += 1e10;
-			}
-			if (IO::file_exists(fea_failed_confirmation_file)) {
-				fea_failed = true;
-				cout << "WARNING: Setting fitness to -infinity for individual " << to_string(i - pop_offset) << " because FEA failed for one or more of its FEA cases.\n";
-				population->at(i).fitness = -INFINITY;
-				break;
-			}
-		}
-		if (fea_failed) continue;
+	string results_path = folder + "/" + fea_casemanager->get_results_filename(case_name);
+	ProcessLimiter::Slot slot(solver_processes);
+	bool solved = fessga::phys::solve_elmer_case(folder, case_name, results_path, retry_policy);
+	if (!solved) cout << "- ERROR:   Failed to produce a results file on case '" << results_path << "'\n";
+	return solved;
+}
 
-		// Load physics
-		load_physics(&population->at(i), mesh);
-		if (verbose && (pop_size < 10 || (i + 1) % (pop_size / 5) == 0))
-			cout << "- Read stress distribution for individual " << i - pop_offset + 1 << " / " << pop_size << "\n";
+// Obtain the FEA results of the given individual, or invalidate it if FEA failed for one of its cases. The nodal values
+// of each case are only kept if <keep_case_fields> is set (i.e. if the individual is archived).
+void load_FEA_results(evo::Individual2d* individual, bool fea_failed, msh::SurfaceMesh* mesh, bool keep_case_fields = false) {
+	if (fea_failed) {
+		cout << "WARNING: Setting fitness to -infinity for individual in " << individual->output_folder
+			<< " because FEA failed for one or more of its FEA cases.\n";
+		individual->fitness = -INFINITY;
+		return;
 	}
+	load_physics(individual, mesh, false, keep_case_fields, &individual->fe_mesh.node_grid_indices);
 }
 
 /*
 Get variation within the given population.
-Variation is not the same as variance; it is determined by the number of times each solution differs from another solution
-where the 'other solution' is randomly chosen from the population (to avoid doing a costly n^2 check of all combinations
-of solutions).
+Variation is not the same as variance; it is determined by the mean number of cells in which each solution differs from
+the other solutions (see PackedPopulation). By default all pairs are compared. For large populations, the mean distances
+can instead be estimated from <no_samples> random others per solution, or from MinHash sketches with <no_sketch_bins> bins.
 */
-float get_variation(vector<evo::Individual2d>* population) {
-	float sum_of_sq_diffs = 0;
+float get_variation(vector<evo::Individual2d>* population, int no_samples = 0, int no_sketch_bins = 0) {
+	if (population->size() < 2) return 0;
+	PackedPopulation packed_population(population);
+	vector<double> mean_distances;
+	if (no_sketch_bins > 0) mean_distances = packed_population.get_sketched_mean_distances(no_sketch_bins);
+	else mean_distances = packed_population.get_mean_distances(no_samples);
+	double sum_of_sq_diffs = 0;
 	int cumulative_count = 0;
-	for (int i = 0; i < population->size(); i++) {
-		int individual_diff = 0;
-		for (int c = 0; c < population->at(0).size; c++) {
-			int other_indiv_idx = i;
-			while (other_indiv_idx == i) {
-				other_indiv_idx = fessga::help::get_rand_uint(0, population->size() - 1);
-			}
-			individual_diff += population->at(i)[c] != population->at(other_indiv_idx)[c];
-		}
-		sum_of_sq_diffs += individual_diff * individual_diff;
-		cumulative_count += population->at(i).count();
+	for (int i = 0; i < packed_population.size(); i++) {
+		sum_of_sq_diffs += mean_distances[i] * mean_distances[i];
+		cumulative_count += packed_population.get_count(i);
 	}
-	cumulative_count = cumulative_count / population->size();
+	cumulative_count = max(1, cumulative_count / packed_population.size());
 	float variation = sqrt(sum_of_sq_diffs) / (float)cumulative_count;
 
 	return variation;
@@ -195,7 +251,9 @@ bool variation_minimum_passed(vector<evo::Individual2d>* population, float thres
 }
 
 void Evolver::collect_stats() {
-	variation = get_variation(&population);
+	if (population.size() <= exact_diversity_limit) variation = get_variation(&population);
+	else if (diversity_estimate == "minhash") variation = get_variation(&population, 0, no_diversity_samples);
+	else variation = get_variation(&population, no_diversity_samples);
 	auto [
 		_fitness_mean, _fitness_stdev, _fitness_time_derivative, _relative_area_mean,
 			_relative_area_stdev, _relative_max_stress_mean, _relative_max_stress_stdev
@@ -214,7 +272,7 @@ void Evolver::export_stats(string iteration_name, bool verbose) {
 	if (verbose) cout << "Exporting statistics to " << statistics_file << endl;
 	if (initialize) {
 		IO::write_text_to_file(
-			"Iteration, Iteration time, Best fitness, Variation, Fitness mean, Fitness stdev, Fitness Derivative, Mean Relative Area, Stdev Relative Area, Mean Relative Max Stress, Stdev Relative Max Stress, Mutation rate (level 0), Mutation rate (level 1), RAM available(GB), Virtual Memory available(GB), Pagefile available(GB), Percent memory used",
+			"Iteration, Iteration time, Best fitness, Variation, Fitness mean, Fitness stdev, Fitness Derivative, Mean Relative Area, Stdev Relative Area, Mean Relative Max Stress, Stdev Relative Max Stress, Mutation rate (level 0), Mutation rate (level 1), Screening error, Fidelity level, FEA cache hit rate, Evaluations, Create throughput (1/s), Export throughput (1/s), Solve throughput (1/s), Load throughput (1/s), Pipeline stall time (s), RAM available(GB), Virtual Memory available(GB), Pagefile available(GB), Percent memory used",
 			statistics_file
 		);
 		return;
@@ -231,6 +289,17 @@ void Evolver::export_stats(string iteration_name, bool verbose) {
 	stats.push_back(to_string(relative_max_stress_stdev));
 	stats.push_back(to_string(mutation_rate_level0));
 	stats.push_back(to_string(mutation_rate_level1));
+	stats.push_back(to_string(screening_error));
+	stats.push_back(to_string(fidelity_level));
+	stats.push_back(to_string(fea_cache.get_hit_rate()));
+	fea_cache.reset_stats();
+	stats.push_back(to_string(no_evaluations));
+	stats.push_back(to_string(pipeline->get_throughput(EvaluationPipeline::Create)));
+	stats.push_back(to_string(pipeline->get_throughput(EvaluationPipeline::Export)));
+	stats.push_back(to_string(pipeline->get_throughput(EvaluationPipeline::Solve)));
+	stats.push_back(to_string(pipeline->get_throughput(EvaluationPipeline::Load)));
+	stats.push_back(to_string(pipeline->get_stall_time()));
+	pipeline->reset_stats();
 	vector<string> stats = {
 		"Current stats: \n   Variation = " + to_string(variation), "Fitness mean = " + to_string(fitness_mean),
 		"Fitness stdev = " + to_string(fitness_stdev)
@@ -238,79 +307,149 @@ void Evolver::export_stats(string iteration_name, bool verbose) {
 	cout << help::join(&stats, ", ") << endl;
 }
 
-// Do 2-point crossover
+// Set bits [first, last) of the given mask
+void set_mask_range(vector<uint64_t>& mask, int first, int last) {
+	if (first >= last) return;
+	int first_word = first >> 6, last_word = (last - 1) >> 6;
+	uint64_t first_bits = ~(uint64_t)0 << (first & 63);
+	uint64_t last_bits = ~(uint64_t)0 >> (63 - ((last - 1) & 63));
+	if (first_word == last_word) {
+		mask[first_word] |= first_bits & last_bits;
+		return;
+	}
+	mask[first_word] |= first_bits;
+	for (int word = first_word + 1; word < last_word; word++) mask[word] = ~(uint64_t)0;
+	mask[last_word] |= last_bits;
+}
+
+/*
+Combine the packed density values of the parents according to the given mask. Child 1 takes the cells whose mask bit is
+set from parent 1 and the other cells from parent 2, and child 2 takes the complement. The children are overwritten.
+*/
+void Evolver::do_masked_crossover(
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2,
+	vector<uint64_t>* mask
+) {
+	vector<uint64_t> words1, words2;
+	parent1.pack(words1);
+	parent2.pack(words2);
+	for (int word = 0; word < mask->size(); word++) {
+		uint64_t exchanged = (words1[word] ^ words2[word]) & ~mask->at(word);
+		words1[word] ^= exchanged;
+		words2[word] ^= exchanged;
+	}
+	child1.unpack(&words1);
+	child2.unpack(&words2);
+}
+
+// Perform the crossover set by <crossover_method>
+void Evolver::do_crossover(
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2
+) {
+	if (crossover_method == "ux") do_ux_crossover(parent1, parent2, child1, child2);
+	else if (crossover_method == "block") do_block_crossover(parent1, parent2, child1, child2);
+	else if (crossover_method == "spatial") do_spatial_crossover(parent1, parent2, child1, child2);
+	else do_2x_crossover(parent1, parent2, child1, child2);
+}
+
+// Do 2-point crossover. The cells strictly between the two crosspoints are taken from the same parent.
 void Evolver::do_2x_crossover(
-	evo::Individual2d parent1, evo::Individual2d parent2, evo::Individual2d child1, evo::Individual2d child2
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2
 ) {
-	vector<uint> crosspoints = { fessga::help::get_rand_uint(0, no_cells - 1), fessga::help::get_rand_uint(0, no_cells - 1) };
+	vector<uint> crosspoints = { help::get_rand_uint(0, densities.size - 1), help::get_rand_uint(0, densities.size - 1) };
 	uint crosspoint_1 = min(crosspoints[0], crosspoints[1]);
 	uint crosspoint_2 = max(crosspoints[0], crosspoints[1]);
-	//cout << "crosspoint 1: " << crosspoint_1 << ", crosspoint 2: " << crosspoint_2 << endl;
-	for (int x = 0; x < densities.dim_x; x++) {
-		for (int y = 0; y < densities.dim_y; y++) {
-			int coord = x * densities.dim_y + y;
-			if (coord > crosspoint_1 && coord < crosspoint_2) {
-				child1.set(coord, parent1[coord]);
-				child2.set(coord, parent2[coord]);
-			}
-			else {
-				child1.set(coord, parent2[coord]);
-				child2.set(coord, parent1[coord]);
-			}
-		}
-	}
-	child1.update_count();
-	child2.update_count();
+	vector<uint64_t> mask((densities.size + 63) / 64, 0);
+	set_mask_range(mask, crosspoint_1 + 1, crosspoint_2);
+	do_masked_crossover(parent1, parent2, child1, child2, &mask);
 }
 
 // Do uniform crossover
 void Evolver::do_ux_crossover(
-	evo::Individual2d parent1, evo::Individual2d parent2, evo::Individual2d child1, evo::Individual2d child2
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2
 ) {
+	vector<uint64_t> mask((densities.size + 63) / 64);
+	for (auto& word : mask) word = help::get_rand_bits();
+	do_masked_crossover(parent1, parent2, child1, child2, &mask);
+}
+
+/*
+Do block crossover. The grid is divided into blocks of <crossover_block_size> x <crossover_block_size> cells, and each
+block is taken from either parent with equal probability. Unlike 1d crossover, this keeps 2d neighbourhoods intact.
+*/
+void Evolver::do_block_crossover(
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2
+) {
+	int block_size = max(1, crossover_block_size);
+	int no_blocks_x = (densities.dim_x + block_size - 1) / block_size;
+	int no_blocks_y = (densities.dim_y + block_size - 1) / block_size;
+	vector<bool> chosen_blocks(no_blocks_x * no_blocks_y);
+	for (int block = 0; block < chosen_blocks.size(); block++) chosen_blocks[block] = help::get_rand_bits() >> 63;
+	vector<uint64_t> mask((densities.size + 63) / 64, 0);
 	for (int x = 0; x < densities.dim_x; x++) {
-		for (int y = 0; y < densities.dim_y; y++) {
-			int coord = x * densities.dim_y + y;
-			int choice = help::get_rand_uint(0, 1);
-			if (choice) {
-				child1.set(coord, parent1[coord]);
-				child2.set(coord, parent2[coord]);
-			}
-			else {
-				child2.set(coord, parent1[coord]);
-				child1.set(coord, parent2[coord]);
-			}
+		for (int block_y = 0; block_y < no_blocks_y; block_y++) {
+			if (!chosen_blocks[(x / block_size) * no_blocks_y + block_y]) continue;
+			int y = block_y * block_size;
+			set_mask_range(mask, densities.get_idx(x, y), densities.get_idx(x, min(y + block_size, densities.dim_y)));
+		}
+	}
+	do_masked_crossover(parent1, parent2, child1, child2, &mask);
+}
+
+/*
+Do spatial crossover. A random rectangle or circle is placed on the grid, and the cells inside it are exchanged between
+the parents. The patch covers at most half the width and height of the grid.
+*/
+void Evolver::do_spatial_crossover(
+	evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2
+) {
+	int dim_x = densities.dim_x, dim_y = densities.dim_y;
+	vector<uint64_t> mask((densities.size + 63) / 64, 0);
+	if (help::get_rand_bits() >> 63) {
+		int width = help::get_rand_uint(1, max(1, dim_x / 2)), height = help::get_rand_uint(1, max(1, dim_y / 2));
+		int x0 = help::get_rand_uint(0, dim_x - width), y0 = help::get_rand_uint(0, dim_y - height);
+		for (int x = x0; x < x0 + width; x++) set_mask_range(mask, densities.get_idx(x, y0), densities.get_idx(x, y0 + height));
+	}
+	else {
+		float radius = help::get_rand_float(1, max(1, min(dim_x, dim_y) / 4));
+		float center_x = help::get_rand_float(0, dim_x), center_y = help::get_rand_float(0, dim_y);
+		for (int x = max(0, (int)(center_x - radius)); x < min(dim_x, (int)(center_x + radius) + 1); x++) {
+			float dx = (float)x + 0.5 - center_x;
+			if (abs(dx) > radius) continue;
+			float half_height = sqrt(radius * radius - dx * dx);
+			int y0 = max(0, (int)round(center_y - half_height)), y1 = min(dim_y, (int)round(center_y + half_height));
+			set_mask_range(mask, densities.get_idx(x, y0), densities.get_idx(x, max(y0, y1)));
 		}
 	}
-	child1.update_count();
-	child2.update_count();
+	do_masked_crossover(parent1, parent2, child1, child2, &mask);
 }
 
 /*
-Mutate the given solution according to the set mutation rate
+Mutate the given solution according to the set mutation rate. Each cell (level 0) and each 2x2 block of cells (level 1) is
+flipped with a probability equal to the mutation rate. Rather than drawing a random number for every cell or block, the gaps
+between flips are drawn from the geometric distribution (see help::get_rand_skip), so that the cost scales with the number
+of flips instead of the grid size.
 */
 void Evolver::do_2d_mutation(evo::Individual2d& individual, float _mutation_rate_level0, float _mutation_rate_level1) {
 	// Level 0 mutation (bit-by-bit)
-	for (int i = 0; i < no_cells; i++) {
-		// Probability of a bit flip is equal to the mutation rate
-		float rand_val = fessga::help::get_rand_float(0.0, 1.0);
-		bool do_flip = rand_val < _mutation_rate_level0;
-		if (do_flip) {
+	if (_mutation_rate_level0 > 0) {
+		double log_q = log(1.0 - (double)_mutation_rate_level0);
+		for (int i = help::get_rand_skip(log_q); i < no_cells; i += 1 + help::get_rand_skip(log_q)) {
 			individual.set(i, (int)(!individual[i]));
 		}
 	}
 
 	// Level 1 mutation (groups of 4 adjacent bits arranged in a square)
 	vector<pair<int, int>> offsets = { pair(0,0), pair(0,1), pair(1,1), pair(1,0) };
-	for (int x = 0; x < individual.dim_x - 1; x++) {
-		for (int y = 0; y < individual.dim_y - 1; y++) {
-			float rand_val = fessga::help::get_rand_float(0.0, 1.0);
-			bool do_flip = rand_val < _mutation_rate_level1;
-
-			if (do_flip) {
-				for (auto& offset : offsets) {
-					int idx = individual.get_idx(x + offset.first, y + offset.second);
-					individual.set(idx, (int)(!individual[idx]));
-				}
+	int no_blocks = (individual.dim_x - 1) * (individual.dim_y - 1);
+	if (_mutation_rate_level1 > 0 && no_blocks > 0) {
+		double log_q = log(1.0 - (double)_mutation_rate_level1);
+		for (int block = help::get_rand_skip(log_q); block < no_blocks; block += 1 + help::get_rand_skip(log_q)) {
+			int x = block / (individual.dim_y - 1);
+			int y = block % (individual.dim_y - 1);
+			for (auto& offset : offsets) {
+				int idx = individual.get_idx(x + offset.first, y + offset.second);
+				individual.set(idx, (int)(!individual[idx]));
 			}
 		}
 	}
@@ -318,6 +457,44 @@ void Evolver::do_2d_mutation(evo::Individual2d& individual, float _mutation_rate
 	individual.update_count();
 }
 
+/*
+Mutate the given solution, biasing level 0 bit flips using the given cellwise sensitivities (see fem::GridSolver2D::get_sensitivities).
+The expected number of level 0 flips equals that of do_2d_mutation(). Half of these remove boundary cells, preferring cells with low
+sensitivity, and half fill empty cells adjacent to the shape, preferring cells with high sensitivity. Candidates are weighted by
+their rank rather than by their sensitivity value, so that the bias does not depend on the scale of the sensitivities.
+Level 1 mutation is not biased.
+*/
+void Evolver::do_sensitivity_mutation(
+	evo::Individual2d& individual, vector<double>* sensitivities, float _mutation_rate_level0, float _mutation_rate_level1
+) {
+	vector<int> removal_candidates, addition_candidates;
+	for (int i = 0; i < no_cells; i++) {
+		if (individual[i] && individual.get_empty_neighbors(i).size()) removal_candidates.push_back(i);
+		else if (!individual[i] && individual.get_neighbors(i).size()) addition_candidates.push_back(i);
+	}
+	auto compare_sensitivities = [&](int cell1, int cell2) { return sensitivities->at(cell1) < sensitivities->at(cell2); };
+	sort(removal_candidates.begin(), removal_candidates.end(), compare_sensitivities);
+	sort(addition_candidates.begin(), addition_candidates.end(), compare_sensitivities);
+	reverse(addition_candidates.begin(), addition_candidates.end());
+
+	float expected_no_flips = 0.5 * _mutation_rate_level0 * (float)no_cells;
+	for (auto& candidates : { &removal_candidates, &addition_candidates }) {
+		int no_candidates = candidates->size();
+		float weight_sum = (float)(no_candidates + 1) * 0.5;
+		for (int i = 0; i < no_candidates; i++) {
+			float weight = (float)(no_candidates - i) / (float)no_candidates;
+			float flip_probability = min(1.0f, expected_no_flips * weight / weight_sum);
+			if (fessga::help::get_rand_float(0.0, 1.0) < flip_probability) {
+				int cell = candidates->at(i);
+				individual.set(cell, (int)(!individual[cell]));
+			}
+		}
+	}
+
+	// Level 1 mutation
+	do_2d_mutation(individual, 0, _mutation_rate_level1);
+}
+
 void Evolver::create_single_individual(bool verbose) {
 	// Make a copy of the base individual
 	evo::Individual2d individual(&densities);
@@ -346,54 +523,35 @@ void Evolver::create_single_individual(bool verbose) {
 	individual.fill_smaller_fenestrae((int)(help::get_rand_float(min_fraction_cells, max_fraction_cells) * (float)densities.count()), verbose);
 #endif
 
-	// Export the individual's FEA mesh and case.sif file
-	export_individual(&individual, individual_folders[population.size()]);
-
-	// Add the individual to the population
+	// Add the individual to the population, and export its FEA mesh and case.sif files
 	population.push_back(individual);
+	export_individual(&population.back(), individual_folders[population.size() - 1]);
 }
 
 /*
 Initialize a population of unique density distributions. Each differs slightly from the distribution loaded from file.
 */
 void Evolver::init_population(bool verbose) {
-	// Generate the first #no_threads individuals, and then start the FEA batch threads
+	// Each individual is submitted for evaluation on the worker pool as soon as it has been generated
 	cout << "Generating initial population...\n";
-	while (population.size() < NO_FEA_THREADS) create_single_individual(verbose);
-	thread fea_thread1(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 0, verbose);
-	thread fea_thread2(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 1, verbose);
-	thread fea_thread3(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 2, verbose);
-	thread fea_thread4(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 3, verbose);
-	thread fea_thread5(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 4, verbose);
-	thread fea_thread6(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 5, verbose);
-
-	int i = NO_FEA_THREADS;
+	int i = 0;
 	while (population.size() < pop_size) {
 		i++;
 		if (i > pop_size * 2 && population.size() == 0) {
 			throw std::runtime_error("Error: Unable to generate any valid individuals after " + to_string(i) + " attempts.\n");
 		}
+		auto start = chrono::steady_clock::now();
 		create_single_individual();
+		pipeline->record(EvaluationPipeline::Create, seconds_since(start));
 		if (verbose && (pop_size < 10 || population.size() % (pop_size / 10) == 0))
 			cout << "- Generated individual " << population.size() << " / " << pop_size << "\n";
 	}
 	cout << "Finished generating initial population.\n";
-
-	// Start a thread to read the results of the FEA
-	cout << "Starting results loaders...\n";
-	thread results_thread(load_physics_batch, &population, 0, 0, pop_size, &mesh, verbose);
-
-	// Also start a reader in the main thread
-	load_physics_batch(&population, 0, 1, pop_size, &mesh, verbose);
-
-	fea_thread1.join();
-	fea_thread2.join();
-	fea_thread3.join();
-	fea_thread4.join();
-	fea_thread5.join();
-	fea_thread6.join();
-	cout << "FEA of initial population finished.\n";
-	results_thread.join();
+	if (in_process_fea) {
+		evaluate_in_process(0, pop_size, verbose);
+		return;
+	}
+	wait_for_evaluations(verbose);
 	cout << "Read FEA results for all individuals in individual population.\n";
 }
 
@@ -417,6 +575,8 @@ void Evolver::create_iteration_directories(int iteration) {
 		final_valid_iteration_folder = iteration_folder;
 	}
 	
+	open_archive();
+
 	// Create individual folders
 	individual_folders.clear();
 	for (int i = 0; i < pop_size; i++) {
@@ -431,9 +591,10 @@ bool Evolver::termination_condition_reached() {
 	terminate = terminate || iteration_number >= max_iterations;
 	if (iteration_number >= max_iterations) {
 		terminate = true;
-		cout << "\nTerminating emma: Maximum number of iterations (" + to_string(max_iterations) + ") reached.\n";
+		cout << "\nTerminating emma: Maximum number of iterations (" + to_string(max_iterations) + ") reached after "
+			+ to_string(no_evaluations) + " evaluations.\n";
 	}
-	else if (iterations_since_fitness_change > max_iterations_without_change) {
+	else if (iterations_since_fitness_change > max_iterations_without_change && fidelity_level == no_fidelity_levels - 1) {
 		terminate = true;
 		cout << "\nTerminating emma: Maximum number of iterations without a change in best fitness ("
 			+ to_string(max_iterations_without_change) + ") reached.\n";
@@ -450,7 +611,35 @@ bool Evolver::termination_condition_reached() {
 
 void Evolver::do_setup() {
 	cout << "Beginning Evolver run. Saving results to " << output_folder << endl;
+	if (!pool) pool = make_shared<WorkerPool>(no_threads);
+	if (evolution_mode == "steady-state" && in_process_fea) {
+		cout << "WARNING: Steady-state evolution requires FEA on the worker pool. Falling back to generational evolution.\n";
+		evolution_mode = "generational";
+	}
+	if (evolution_mode == "steady-state" && screening_fraction < 1.0) {
+		cout << "WARNING: Pre-screening is not supported in steady-state evolution, and has been disabled.\n";
+		screening_fraction = 1.0;
+	}
+	pipeline->set_capacity(pipeline_capacity > 0 ? pipeline_capacity : 2 * pool->size());
+	if (max_solver_processes <= 0) {
+		// Elmer runs are limited to the physical cores (estimated as half the hardware threads), shared by the islands
+		// running on this machine
+		int no_local_islands = (island_channel && island_channel->hosts.empty()) ? no_islands : 1;
+		max_solver_processes = max(1, (int)thread::hardware_concurrency() / (2 * no_local_islands));
+	}
+	solver_processes->set_capacity(max_solver_processes);
 	export_meta_parameters();
+	population.reserve(2 * pop_size); // Pointers to individuals held by the worker pool's tasks must remain valid
+	if (no_fidelity_levels > 1) {
+		// Start the multi-fidelity schedule on the coarsest grid. The full-resolution densities and FEA cases are kept as
+		// the reference from which each level is resampled.
+		target_densities = densities;
+		target_fea_casemanager = fea_casemanager;
+		target_densities.fea_casemanager = &target_fea_casemanager;
+		set_fidelity_level(0);
+	}
+	else if (in_process_fea) init_solver();
+	init_fea_cache();
 	create_iteration_directories(iteration_number);
 	if (verbose) densities.print();
 	
@@ -458,6 +647,14 @@ void Evolver::do_setup() {
 	init_population();
 	float seconds_since_start = difftime(time(0), start);
 	cout << "Time taken to generate initial population: " << seconds_since_start << endl;
+	if (screening_fraction < 1.0) {
+		// Calibrate the pre-screening proxy using the FEA results of the initial population
+		proxy = fem::CoarseProxy2D(&fea_casemanager, &densities);
+		for (auto& indiv : population) {
+			if (indiv.fitness == -INFINITY) continue;
+			proxy.calibrate(proxy.estimate_max_stress(&indiv, false), indiv.fea_results.max);
+		}
+	}
 	for (auto& indiv : population) {
 		for (auto& keepcell : indiv.fea_casemanager->keep_cells) {
 			if (!indiv[keepcell]) {
@@ -472,6 +669,7 @@ void Evolver::do_setup() {
 	best_individual_idx = (*fitnesses_pairset.begin()).first;
 	current_best_solution_folder = best_solutions_folder + "/" + iteration_name;
 	IO::create_folder_if_not_exists(current_best_solution_folder);
+	create_missing_results_files(&population[best_individual_idx]);
 	copy_solution_files(population[best_individual_idx].output_folder, current_best_solution_folder);
 	collect_stats();
 	export_stats(iteration_name);
@@ -487,7 +685,7 @@ void Evolver::update_objective_function() {
 			") to (" << fea_casemanager.max_stress_threshold << ").\n";
 		cout << "-- Updating fitnesses according to new objective function.\n";
 		fitnesses_map.clear();
-		evaluate_fitnesses(0);
+		evaluate_fitnesses(0, false, true, true);
 	}
 }
 
@@ -500,21 +698,39 @@ void Evolver::choose_parents(vector<evo::Individual2d>& parents, vector<evo::Ind
 	}
 }
 
-// Perform crossover and mutation. If this yields invalid children, retry until valid children are obtained.
-void Evolver::create_valid_child_densities(vector<evo::Individual2d>* parents, vector<evo::Individual2d>& children) {
-	while (true) {
+/*
+Perform crossover and mutation. If this yields invalid children, retry until valid children are obtained. Return false if
+no valid children were obtained within <child_retry_budget> attempts.
+*/
+bool Evolver::create_valid_child_densities(vector<evo::Individual2d>* parents, vector<evo::Individual2d>& children) {
+	// Approximate the children's sensitivities by the mean of the parents' sensitivities
+	vector<double> sensitivities;
+	vector<double>* sensitivities1 = &parents->at(0).fea_results.sensitivities;
+	vector<double>* sensitivities2 = &parents->at(1).fea_results.sensitivities;
+	if (mutation_method == "sensitivity" && sensitivities1->size() == no_cells && sensitivities2->size() == no_cells) {
+		for (int i = 0; i < no_cells; i++) sensitivities.push_back(0.5 * (sensitivities1->at(i) + sensitivities2->at(i)));
+	}
+	for (int attempt = 0; attempt < child_retry_budget; attempt++) {
 		evo::Individual2d child1(&densities), child2(&densities);
-		if (crossover_method == "2x") do_2x_crossover(parents->at(0), parents->at(1), child1, child2);
-		else if (crossover_method == "ux") do_ux_crossover(parents->at(0), parents->at(1), child1, child2);
+		do_crossover(parents->at(0), parents->at(1), child1, child2);
 		children = { child1, child2 };
 		bool valid = true;
 		for (auto& child : children) {
-			do_2d_mutation(child, mutation_rate_level0, mutation_rate_level1);
+			if (sensitivities.size()) do_sensitivity_mutation(child, &sensitivities, mutation_rate_level0, mutation_rate_level1);
+			else do_2d_mutation(child, mutation_rate_level0, mutation_rate_level1);
 			valid = child.repair();
 			if (!valid) break;
 		}
-		if (valid) break;
+		if (valid) return true;
+		for (auto& child : children) child.delete_arrays();
 	}
+	children.clear();
+	return false;
+}
+
+// Get the random stream from which the given pair of children of the current iteration is created
+uint64_t Evolver::get_child_stream(int pair) {
+	return ((uint64_t)island << 48) | ((uint64_t)iteration_number << 24) | (uint64_t)(pair + 1);
 }
 
 void Evolver::create_individual_mesh(evo::Individual2d* individual, bool verbose) {
@@ -528,72 +744,197 @@ void Evolver::create_individual_mesh(evo::Individual2d* individual, bool verbose
 	string batch_file = msh::create_batch_file(individual->output_folder);
 }
 
-void Evolver::export_individual(evo::Individual2d* individual, string folder) {
+/*
+Prepare the given individual for evaluation. Unless its FEA results are taken from the cache or FEA is done in-process,
+it is submitted for evaluation on the worker pool. Since the pool's tasks hold a pointer to the individual, it must already
+have its final place in the population. If given, <on_evaluated> is called once the individual's FEA results are
+available, which may be immediately.
+*/
+void Evolver::export_individual(evo::Individual2d* individual, string folder, function<void()> on_evaluated) {
 	individual->output_folder = folder;
 	individual->iteration = iteration_number;
-	create_individual_mesh(individual);
-	create_sif_files(individual, &individual->fe_mesh, verbose);
+	if (fetch_cached_results(individual) || in_process_fea) {
+		// Either the individual's density distribution was evaluated before, so that FEA can be skipped, or no FE mesh
+		// or case files are needed. Only export the density distribution.
+		individual->do_export(individual->output_folder + "/distribution2d.dens");
+		if (on_evaluated) on_evaluated();
+		return;
+	}
+#ifndef FEA_IGNORE
+	submit_evaluation(individual, on_evaluated);
+#else
+	if (on_evaluated) on_evaluated();
+#endif
 }
 
+/*
+Submit the evaluation of the given individual to the worker pool. Its FE mesh and case files are exported by one task,
+which then submits a task per FEA case. The task that completes the last case loads the results. Blocks while the
+evaluation pipeline is full (see EvaluationPipeline).
+*/
+void Evolver::submit_evaluation(evo::Individual2d* individual, function<void()> on_evaluated) {
+	pipeline->enter();
+	pool->submit([this, individual, on_evaluated] {
+		auto start = chrono::steady_clock::now();
+		bool exported = try_evaluation_step("Export of FE mesh and case files", individual->output_folder, [this, individual] {
+			create_individual_mesh(individual);
+			create_sif_files(individual, &individual->fe_mesh);
+		});
+		pipeline->record(EvaluationPipeline::Export, seconds_since(start));
+		if (!exported) {
+			load_FEA_results(individual, true, &mesh);
+			pipeline->leave();
+			if (on_evaluated) on_evaluated();
+			return;
+		}
+		auto no_remaining_cases = make_shared<atomic<int>>(fea_casemanager.active_cases.size());
+		auto fea_failed = make_shared<atomic<bool>>(false);
+		for (auto& fea_case : fea_casemanager.active_cases) {
+			pool->submit([this, individual, on_evaluated, case_name = fea_case.name, no_remaining_cases, fea_failed] {
+				auto start = chrono::steady_clock::now();
+				bool solved = false;
+				try_evaluation_step("FEA of case '" + case_name + "'", individual->output_folder, [&] {
+					solved = run_FEA_case(
+						individual->output_folder, case_name, &fea_casemanager, fea_retry_policy, solver_processes.get()
+					);
+				});
+				if (!solved) *fea_failed = true;
+				pipeline->record(EvaluationPipeline::Solve, seconds_since(start));
+				if (--(*no_remaining_cases) > 0) return;
+				start = chrono::steady_clock::now();
+				bool loaded = try_evaluation_step("Loading of FEA results", individual->output_folder, [&] {
+					load_FEA_results(individual, *fea_failed, &mesh, archive_results);
+				});
+				if (!loaded) load_FEA_results(individual, true, &mesh);
+				pipeline->record(EvaluationPipeline::Load, seconds_since(start));
+				pipeline->leave();
+				if (on_evaluated) on_evaluated();
+			});
+		}
+	});
+}
+
+// Block until the worker pool has finished evaluating all submitted individuals, reporting progress at regular intervals
+void Evolver::wait_for_evaluations(bool verbose) {
+	while (!pool->wait_for(30)) {
+		if (verbose) cout << "- Waiting for " << pool->no_pending() << " pending FEA tasks...\n";
+	}
+}
+
+/*
+Create <pop_size> children. Each pair of children is created by a task on the worker pool, which draws from its own random
+stream (see get_child_stream). The pairs are added to the population in order of their slot as soon as they are ready,
+so that the result does not depend on the order in which the tasks finish.
+*/
 void Evolver::create_children(bool verbose) {
 	cout << "Generating children...\n";
-	vector<int> parent_indices;
 	vector<evo::Individual2d> previous_population = population;
+	int no_pairs = pop_size / 2;
+	vector<vector<evo::Individual2d>> parent_pairs(no_pairs), child_pairs(no_pairs);
+	for (auto& parents : parent_pairs) choose_parents(parents, &previous_population);
+	auto created_pairs = make_shared<CompletionQueue<int>>();
+	for (int i = 0; i < no_pairs; i++) {
+		pool->submit([this, i, &parent_pairs, &child_pairs, created_pairs] {
+			help::set_rand_stream(get_child_stream(i));
+			auto start = chrono::steady_clock::now();
+			if (!create_valid_child_densities(&parent_pairs[i], child_pairs[i])) {
+				cout << "- WARNING: Unable to create valid children of pair " << i + 1 << " within " << child_retry_budget
+					<< " attempts. Copying the parents instead.\n";
+				child_pairs[i] = { evo::Individual2d(&parent_pairs[i][0]), evo::Individual2d(&parent_pairs[i][1]) };
+			}
+			pipeline->record(EvaluationPipeline::Create, seconds_since(start), 2);
+			created_pairs->push(i);
+		});
+	}
 
-	// First create #NO_FEA_THREADS children to be able to begin FEA
-	for (int i = 0; i < (NO_FEA_THREADS / 2); i++) {
-		vector<evo::Individual2d> parents;
-		choose_parents(parents, &previous_population);
-		vector<evo::Individual2d> children;
-		create_valid_child_densities(&parents, children);
+	// Children are submitted for evaluation as soon as they have been created. If pre-screening is enabled, all children
+	// are created and screened first, since the screening determines which children are sent to FEA.
+	bool do_screening = screening_fraction < 1.0 && !in_process_fea;
+	vector<bool> created(no_pairs, false);
+	for (int i = 0; i < no_pairs; i++) {
+		while (!created[i]) created[created_pairs->pop()] = true;
 		for (int j = 0; j < 2; j++) {
-			export_individual(&children[j], individual_folders[i * 2 + j]);
-			population.push_back(children[j]);
+			population.push_back(child_pairs[i][j]);
+			if (!do_screening) export_individual(&population.back(), individual_folders[i * 2 + j]);
 		}
 		if (verbose && (population.size() < 20 || (i + 1) % (pop_size / 10) == 0))
 			cout << "- Created child " << (i + 1) * 2 << " / " << pop_size << "\n";
 	}
-#ifndef FEA_IGNORE
-	thread fea_thread1(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 0, verbose);
-	thread fea_thread2(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 1, verbose);
-	thread fea_thread3(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 2, verbose);
-	thread fea_thread4(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 3, verbose);
-	thread fea_thread5(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 4, verbose);
-	thread fea_thread6(run_FEA_batch, individual_folders, &fea_casemanager, pop_size, 5, verbose);
-#endif
-	// Generate rest of children
-	for (int i = NO_FEA_THREADS / 2; i < (pop_size / 2); i++) {
-		vector<evo::Individual2d> parents;
-		choose_parents(parents, &previous_population);
-		vector<evo::Individual2d> children;
-		create_valid_child_densities(&parents, children);
-		for (int j = 0; j < 2; j++) {
-			export_individual(&children[j], individual_folders[i * 2 + j]);
-			population.push_back(children[j]);
-		}
-		if (verbose && (population.size() < 20 || (i+1) % (pop_size / 10) == 0))
-			cout << "- Created child " << (i+1)*2 << " / " << pop_size << "\n";
-	}
+	if (do_screening) screen_children(verbose);
 	cout << "Finished generating children.\n";
-
-#ifndef FEA_IGNORE
-	// Start a thread to read the results of the FEA
-	cout << "Starting results loaders...\n";
-	thread results_thread(load_physics_batch, &population, pop_size, 0, pop_size, &mesh, verbose);
-	
-	// Also start a reader in the main thread
-	load_physics_batch(&population, pop_size, 1, pop_size, &mesh, verbose);
-
-	// Join threads
-	fea_thread1.join();
-	fea_thread2.join();
-	fea_thread3.join();
-	fea_thread4.join();
-	fea_thread5.join();
-	fea_thread6.join();
-	results_thread.join();
+	if (in_process_fea) {
+		evaluate_in_process(pop_size, pop_size, verbose);
+		return;
+	}
+	wait_for_evaluations(verbose);
 	cout << "Finished reading FEA results for all children.\n";
-#endif
+	if (do_screening) update_screening_stats();
+}
+
+/*
+Estimate the fitness of each newly created child using the coarse proxy solver, and only export the most promising
+children for full FEA. The remaining children keep their proxy estimate, and are marked as such by their
+'fitness_is_proxy' flag. A small number of randomly chosen screened-out children is nevertheless fully evaluated,
+so that the rate at which screening discards children that should have been kept can be measured.
+*/
+void Evolver::screen_children(bool verbose) {
+	cout << "Pre-screening children...\n";
+	map<int, double> proxy_fitnesses;
+	for (int i = 0; i < pop_size; i++) {
+		evo::Individual2d* child = &population[pop_size + i];
+		child->proxy_max_stress = proxy.estimate_max_stress(child, false);
+		proxy_fitnesses.insert(pair(i, get_fitness(child->proxy_max_stress * proxy.calibration, child->get_relative_area())));
+	}
+	PairSet proxy_fitnesses_pairset;
+	help::sort(proxy_fitnesses, proxy_fitnesses_pairset);
+	vector<int> ranking;
+	for (auto& [i, _] : proxy_fitnesses_pairset) ranking.push_back(i);
+	reverse(ranking.begin(), ranking.end());
+
+	// Select the children that receive a full evaluation
+	int no_promising = max(1, (int)round(screening_fraction * (float)pop_size));
+	vector<int> fully_evaluated(ranking.begin(), ranking.begin() + no_promising);
+	screening_cutoff = proxy_fitnesses[ranking[no_promising - 1]];
+	vector<int> screened_out(ranking.begin() + no_promising, ranking.end());
+	audited_children.clear();
+	while (audited_children.size() < screening_audit_size && screened_out.size()) {
+		int idx = help::get_rand_uint(0, screened_out.size() - 1);
+		audited_children.push_back(screened_out[idx]);
+		fully_evaluated.push_back(screened_out[idx]);
+		screened_out.erase(screened_out.begin() + idx);
+	}
+
+	for (auto& i : fully_evaluated) export_individual(&population[pop_size + i], individual_folders[i]);
+	for (auto& i : screened_out) {
+		evo::Individual2d* child = &population[pop_size + i];
+		child->output_folder = individual_folders[i];
+		child->iteration = iteration_number;
+		child->fitness_is_proxy = true;
+		child->fea_results.clear();
+		child->fea_results.min = 0;
+		child->fea_results.max = child->proxy_max_stress * proxy.calibration;
+		child->do_export(child->output_folder + "/distribution2d.dens");
+	}
+	if (verbose) cout << "- Sending " << fully_evaluated.size() << " / " << pop_size << " children to FEA.\n";
+}
+
+/*
+Compare the proxy estimates of all fully evaluated children to their FEA results. Screening was wrong for a child if
+its proxy fitness and its actual fitness lie on different sides of the screening cutoff. The FEA results are also used
+to refine the proxy's calibration.
+*/
+void Evolver::update_screening_stats() {
+	int no_evaluated = 0, no_wrong = 0;
+	for (int i = 0; i < pop_size; i++) {
+		evo::Individual2d* child = &population[pop_size + i];
+		if (child->fitness_is_proxy || child->fitness == -INFINITY) continue;
+		proxy.calibrate(child->proxy_max_stress, child->fea_results.max);
+		double fitness = get_fitness(child->fea_results.max, child->get_relative_area());
+		bool was_kept = !help::is_in(&audited_children, i);
+		no_wrong += was_kept != (fitness >= screening_cutoff);
+		no_evaluated++;
+	}
+	if (no_evaluated) screening_error = (float)no_wrong / (float)no_evaluated;
 }
 
 void Evolver::export_meta_parameters(vector<string>* _) {
@@ -606,44 +947,62 @@ void Evolver::export_meta_parameters(vector<string>* _) {
 		"mutation rate level 1 = " + to_string(mutation_rate_level1),
 		"max iterations since fitness change = " + to_string(max_iterations_without_change),
 		"crossover method = " + crossover_method,
-		"mechanical constraint = " + fea_casemanager.mechanical_constraint
+		"mechanical constraint = " + fea_casemanager.mechanical_constraint,
+		"screening fraction = " + to_string(screening_fraction),
+		"screening audit size = " + to_string(screening_audit_size),
+		"fidelity levels = " + to_string(no_fidelity_levels),
+		"refinement trigger = " + to_string(refinement_trigger),
+		"in-process FEA = " + string(in_process_fea ? "yes" : "no"),
+		"mutation method = " + mutation_method,
+		"FEA cache size = " + to_string(fea_cache.capacity),
+		"FEA cache file = " + fea_cache.path,
+		"archive results = " + string(archive_results ? "yes" : "no"),
+		"superposition mode = " + superposition_mode,
+		"worker threads = " + to_string(pool ? pool->size() : no_threads),
+		"max solver processes = " + to_string(max_solver_processes),
+		"FEA attempts = " + to_string(fea_retry_policy.max_attempts),
+		"FEA results timeout = " + to_string(fea_retry_policy.results_timeout),
+		"pipeline capacity = " + to_string(pipeline->capacity),
+		"evolution mode = " + evolution_mode,
+		"replacement method = " + replacement_method,
+		"island = " + to_string(island + 1) + " / " + to_string(no_islands),
+		"migration interval = " + to_string(migration_interval),
+		"migrants = " + to_string(no_migrants)
 	};
 	OptimizerBase::export_meta_parameters(&additional_metaparameters);
 }
 
-void Evolver::evaluate_fitnesses(int offset, bool do_FEA, bool verbose) {
+double Evolver::get_fitness(double max_stress, double relative_area) {
+	if (max_stress > fea_casemanager.max_stress_threshold) {
+		return 1.0 - max_stress / fea_casemanager.max_stress_threshold;
+	}
+	double relative_maximum_stress = (fea_casemanager.max_stress_threshold - max_stress) / fea_casemanager.max_stress_threshold;
+	return (relative_maximum_stress * stress_fitness_influence + 1.0) / relative_area;
+}
+
+// Compute the fitness of the given individual from its FEA results, without any of the bookkeeping of evaluate_fitness
+double Evolver::get_fitness(evo::Individual2d* individual) {
+	if (individual->fitness == -INFINITY) return -INFINITY;
+	return get_fitness(individual->fea_results.max, individual->get_relative_area());
+}
+
+// Compute the fitnesses of <pop_size> individuals, starting at <offset>. If <rescore> is set, the individuals were evaluated
+// before (e.g. before the objective function changed), so their fitnesses are only recomputed (see get_fitness).
+void Evolver::evaluate_fitnesses(int offset, bool do_FEA, bool verbose, bool rescore) {
 	cout << "Evaluating individual fitnesses...\n";
 	iterations_since_fitness_change++;
 
 	// Obtain FEA results and compute fitnesses
 	for (int i = offset; i < (pop_size + offset); i++) {
 		if (verbose && (i % (pop_size / 5) == 0)) cout << "max stress: " << population[i].fea_results.max << endl;
-
-		// Determine fitness
-		double fitness;
-		if (population[i].fitness == -INFINITY) {
-			fitness = -INFINITY;
-			if (!help::is_in(&iterations_with_fea_failure, iteration_number)) iterations_with_fea_failure.push_back(iteration_number);
-		}
-		else if (population[i].fea_results.max > fea_casemanager.max_stress_threshold) {
-			fitness = 1.0 - population[i].fea_results.max / fea_casemanager.max_stress_threshold;
-		}
-		else {
-			double relative_maximum_stress = (fea_casemanager.max_stress_threshold - population[i].fea_results.max) / fea_casemanager.max_stress_threshold;
-			fitness = (relative_maximum_stress * stress_fitness_influence + 1.0) / (population[i].get_relative_area());
-		}
+		double fitness = rescore ? get_fitness(&population[i]) : evaluate_fitness(&population[i]);
 		if (verbose && (i % (pop_size/5) == 0)) cout << "fitness: " << fitness << endl;
 
 		// Add fitness to map
 		fitnesses_map.insert(pair(i, fitness));
 
-		// Store stress value of strongest (i.e. lowest-stress/displacement) individual 
-		if (population[i].fea_results.max < minimum_stress) {
-			minimum_stress = population[i].fea_results.max;
-		}
-
-		// Update best fitness if improved
-		if (fitness > best_fitness) {
+		// Update best fitness if improved. Individuals with a proxy fitness are not eligible, since they have no FEA results.
+		if (fitness > best_fitness && !population[i].fitness_is_proxy) {
 			best_fitness = fitness;
 			best_individual_idx = i;
 			iterations_since_fitness_change = 0;
@@ -659,6 +1018,41 @@ void Evolver::evaluate_fitnesses(int offset, bool do_FEA, bool verbose) {
 	}
 }
 
+/*
+Compute the fitness of a newly evaluated individual from its FEA results, and do the bookkeeping of the evaluation: the
+individual is counted, archived, and its newly obtained FEA results are stored in the cache. Once archived, the
+individual's folder is removed, unless the evaluation failed or the individual may become the best solution (whose files
+are copied to the best solutions folder). Must be called once per evaluation; to recompute the fitness of an individual
+that was evaluated before, use get_fitness.
+*/
+double Evolver::evaluate_fitness(evo::Individual2d* individual) {
+	no_evaluations++;
+	double fitness = get_fitness(individual);
+	if (fitness == -INFINITY && !help::is_in(&iterations_with_fea_failure, iteration_number)) {
+		iterations_with_fea_failure.push_back(iteration_number);
+	}
+	if (archive_results) {
+		archive_individual(individual, fitness);
+		bool keep_folder = fitness == -INFINITY || (fitness >= best_fitness && !individual->fitness_is_proxy);
+		if (!keep_folder) IO::remove_directory_incl_contents(individual->output_folder);
+	}
+
+	// Store newly obtained FEA results in the cache
+	if (fitness != -INFINITY && !individual->fitness_is_proxy && !individual->fitness_is_cached) {
+		fea_cache.insert(
+			fea_cache.get_key(individual->get_values(), individual->size, individual->dim_x, individual->dim_y),
+			&individual->fea_results, iteration_number
+		);
+	}
+	individual->fea_results.case_fields.clear(); // Only needed for archiving
+
+	// Store stress value of strongest (i.e. lowest-stress/displacement) individual 
+	if (individual->fea_results.max < minimum_stress) {
+		minimum_stress = individual->fea_results.max;
+	}
+	return fitness;
+}
+
 void Evolver::do_selection() {
 	cout << "Performing truncation selection...\n";
 
@@ -710,22 +1104,372 @@ void Evolver::do_selection() {
 	}
 
 	// If current iteration produced a new best solution, export this solution to the 'best_solutions' folder
-	if (iterations_since_fitness_change == 0) {
-		string target_folder = IO::create_folder_if_not_exists(best_solutions_folder + "/" + iteration_name);
-		copy_solution_files(population[best_individual_idx].output_folder, best_solutions_folder + "/" + iteration_name);
-		current_best_solution_folder = best_solutions_folder + "/" + iteration_name;
+	if (iterations_since_fitness_change == 0) export_best_solution();
+}
+
+// Export the best solution of the current iteration to the 'best_solutions' folder
+void Evolver::export_best_solution() {
+	string target_folder = IO::create_folder_if_not_exists(best_solutions_folder + "/" + iteration_name);
+	create_missing_results_files(&population[best_individual_idx]);
+	copy_solution_files(population[best_individual_idx].output_folder, best_solutions_folder + "/" + iteration_name);
+	current_best_solution_folder = best_solutions_folder + "/" + iteration_name;
 		
-		// Also write a superposition of stress values to the target folder as a .vtk file
-		uint* densities = new uint[population[best_individual_idx].dim_x * population[best_individual_idx].dim_y];
-		population[best_individual_idx].copy_to(densities);
-		phys::write_results_superposition(
-			population[best_individual_idx].vtk_paths, population[best_individual_idx].dim_x, population[best_individual_idx].dim_y,
-			population[best_individual_idx].cell_size, mesh.offset, target_folder + "/SuperPosition.vtk", fea_casemanager.mechanical_constraint
-		);
-		delete[] densities;
+	// Also queue a superposition of stress values, to be written to the target folder as a .vtk file
+	queue_superposition(&population[best_individual_idx], target_folder);
+}
+
+/*
+Evaluate <pop_size> children in steady-state fashion. Instead of waiting for a whole generation to be evaluated, a new
+child is created and submitted whenever the evaluation pipeline has room, so the solvers are never idle waiting for the
+slowest evaluation of a generation. Parents are chosen from the population as it is at that moment, and each evaluated
+child immediately competes for a place in the population (see replace_individual).
+*/
+void Evolver::run_steady_state_epoch(bool verbose) {
+	cout << "Evaluating " << pop_size << " children in steady-state mode...\n";
+	iterations_since_fitness_change++;
+	vector<evo::Individual2d> children;
+	children.reserve(pop_size); // Pointers to children held by the worker pool's tasks must remain valid
+	int no_in_flight = 0, no_evaluated = 0, no_inserted = 0;
+	auto process_child = [&](int slot) {
+		no_in_flight--;
+		no_evaluated++;
+		double fitness = evaluate_fitness(&children[slot]);
+		if (replace_individual(&children[slot], fitness)) no_inserted++;
+		else children[slot].delete_arrays();
+		if (verbose && (no_evaluated < 20 || no_evaluated % (pop_size / 10) == 0))
+			cout << "- Evaluated child " << no_evaluated << " / " << pop_size << "\n";
+	};
+	while (no_evaluated < pop_size) {
+		// Let children that have been evaluated compete for a place in the population first, so that they can be chosen as parents
+		int slot;
+		while (evaluated_children->try_pop(slot)) process_child(slot);
+		if (children.size() == pop_size || no_in_flight >= pipeline->capacity) {
+			if (no_evaluated < pop_size) process_child(evaluated_children->pop());
+			continue;
+		}
+		int parent1 = help::get_rand_uint(0, pop_size - 1), parent2 = parent1;
+		while (parent2 == parent1 && pop_size > 1) parent2 = help::get_rand_uint(0, pop_size - 1);
+		vector<evo::Individual2d> parents = { population[parent1], population[parent2] };
+		vector<evo::Individual2d> new_children;
+		auto start = chrono::steady_clock::now();
+		if (!create_valid_child_densities(&parents, new_children)) {
+			cout << "- WARNING: Unable to create valid children within " << child_retry_budget
+				<< " attempts. Copying the parents instead.\n";
+			new_children = { evo::Individual2d(&parents[0]), evo::Individual2d(&parents[1]) };
+		}
+		pipeline->record(EvaluationPipeline::Create, seconds_since(start), 2);
+		for (auto& child : new_children) {
+			if (children.size() == pop_size) {
+				child.delete_arrays();
+				continue;
+			}
+			children.push_back(child);
+			int slot = children.size() - 1;
+			no_in_flight++;
+			export_individual(&children.back(), individual_folders[slot], [this, slot] { evaluated_children->push(slot); });
+		}
+	}
+	cout << "- " << no_inserted << " / " << pop_size << " children entered the population.\n";
+	if (iterations_since_fitness_change == 0) {
+		cout << "EMMA: new best fitness: " << best_fitness << endl;
+		export_best_solution();
+	}
+}
+
+/*
+Let the given evaluated child compete for a place in the population. With replacement method "worst", the child replaces
+the least fit individual in the population, and with "tournament" the least fit of <replacement_tournament_size>
+randomly chosen individuals. The child only takes that individual's place if it is at least as fit. Return whether the
+child was inserted.
+*/
+bool Evolver::replace_individual(evo::Individual2d* child, double fitness) {
+	if (fitness == -INFINITY) return false;
+	int replaced_idx = -1;
+	if (replacement_method == "tournament") {
+		for (int i = 0; i < replacement_tournament_size; i++) {
+			int idx = help::get_rand_uint(0, population.size() - 1);
+			if (replaced_idx == -1 || fitnesses_map[idx] < fitnesses_map[replaced_idx]) replaced_idx = idx;
+		}
+	}
+	else {
+		for (auto& [idx, _fitness] : fitnesses_map) {
+			if (replaced_idx == -1 || _fitness < fitnesses_map[replaced_idx]) replaced_idx = idx;
+		}
+	}
+	if (fitness < fitnesses_map[replaced_idx]) return false;
+	population[replaced_idx].delete_arrays();
+	population[replaced_idx] = *child;
+	fitnesses_map[replaced_idx] = fitness;
+	if (fitness > best_fitness) {
+		best_fitness = fitness;
+		best_individual_idx = replaced_idx;
+		iterations_since_fitness_change = 0;
+	}
+	return true;
+}
+
+/*
+Join a ring of <_no_islands> evolvers, each running as a separate process, and connect to the neighbouring islands (see
+IslandChannel). Every <options.migration_interval> iterations, each island sends its <options.no_migrants> fittest
+individuals to the next island. All islands must be started with the same number of islands and the same port; they may
+run on several nodes if the host of each island is given. Return whether the connections were made; if not, the evolver
+runs on its own.
+*/
+bool Evolver::join_islands(int _island, int _no_islands, IslandOptions options) {
+	island = _island;
+	no_islands = _no_islands;
+	migration_interval = max(1, options.migration_interval);
+	no_migrants = min(max(1, options.no_migrants), pop_size);
+	migration_timeout = options.migration_timeout;
+
+	// Give each island its own random stream of the run seed, so that islands started with the same seed still differ
+	help::set_rand_stream((uint64_t)island << 48);
+	if (no_islands < 2) return false;
+	cout << "Island " << island + 1 << " / " << no_islands << ": Connecting to neighbouring islands...\n";
+	island_channel = make_shared<IslandChannel>();
+	if (!island_channel->open(island, no_islands, options.base_port, options.hosts)) {
+		cout << "WARNING: Unable to connect to the neighbouring islands. Evolving without migration.\n";
+		island_channel.reset();
+		return false;
+	}
+	return true;
+}
+
+/*
+Send the fittest individuals to the next island, and let the migrants received from the previous island compete for a
+place in the population (see replace_individual). Migrants are re-evaluated, since the fitness an island assigns depends
+on its current stress threshold. Migrants that the previous island found less fit than the least fit individual in the
+population are discarded without evaluation.
+*/
+void Evolver::migrate(bool verbose) {
+	help::sort(fitnesses_map, fitnesses_pairset);
+	vector<Migrant> emigrants;
+	for (auto it = fitnesses_pairset.rbegin(); it != fitnesses_pairset.rend() && emigrants.size() < no_migrants; it++) {
+		evo::Individual2d* individual = &population[it->first];
+		Migrant migrant;
+		migrant.dim_x = individual->dim_x;
+		migrant.dim_y = individual->dim_y;
+		migrant.fitness = it->second;
+		migrant.set_densities(individual->get_values(), individual->size);
+		emigrants.push_back(migrant);
+	}
+	// The emigrants are sent while the immigrants are received. If every island first sent and then received, batches larger
+	// than the socket buffers would block all islands in send().
+	vector<Migrant> immigrants;
+	bool sent = false;
+	thread sender([this, &emigrants, &sent] { sent = island_channel->send(&emigrants, migration_timeout); });
+	bool received = island_channel->receive(immigrants, migration_timeout);
+	sender.join();
+	if (!sent || !received) {
+		cout << "WARNING: Island " << island + 1 << " failed to exchange migrants. Evolving without migration from now on.\n";
+		island_channel.reset();
+		return;
+	}
+
+	// Evaluate the immigrants. They are temporarily placed at the end of the population.
+	double worst_fitness = fitnesses_pairset.begin()->second;
+	int offset = population.size();
+	for (auto& migrant : immigrants) {
+		if (migrant.dim_x != densities.dim_x || migrant.dim_y != densities.dim_y || migrant.fitness < worst_fitness) continue;
+		evo::Individual2d immigrant(&densities);
+		for (int cell = 0; cell < immigrant.size; cell++) immigrant.set(cell, migrant.get_density(cell));
+		immigrant.update_count();
+		int i = population.size() - offset + 1;
+		string folder = IO::create_folder_if_not_exists(iteration_folder + help::add_padding("/immigrant_", i) + to_string(i));
+		population.push_back(immigrant);
+		export_individual(&population.back(), folder);
+	}
+	int no_immigrants = population.size() - offset;
+	if (in_process_fea) evaluate_in_process(offset, no_immigrants);
+	else wait_for_evaluations();
+
+	double previous_best_fitness = best_fitness;
+	int no_inserted = 0;
+	while (population.size() > offset) {
+		evo::Individual2d immigrant = population.back();
+		population.pop_back();
+		double fitness = evaluate_fitness(&immigrant);
+		if (replace_individual(&immigrant, fitness)) no_inserted++;
+		else immigrant.delete_arrays();
+	}
+	if (verbose) cout << "Island " << island + 1 << ": " << no_inserted << " / " << immigrants.size() << " immigrants entered the population.\n";
+	if (best_fitness > previous_best_fitness) {
+		cout << "EMMA: new best fitness (immigrant): " << best_fitness << endl;
+		export_best_solution();
 	}
 }
 
+// Resample the base densities and the FEA cases to the grid resolution of the given level of the multi-fidelity schedule
+void Evolver::set_fidelity_level(int level) {
+	fidelity_level = level;
+	iterations_at_fidelity_level = 0;
+	int level_dim_x = target_densities.dim_x >> (no_fidelity_levels - 1 - level);
+	double max_stress_threshold = fea_casemanager.max_stress_threshold;
+	// At level 0, the densities still share their arrays with the target densities
+	if (level > 0) densities.delete_arrays();
+	densities = grd::Densities2d(level_dim_x, target_densities.diagonal, target_densities.output_folder);
+	target_densities.resample_to(&densities);
+	msh::resample_fea_casemanager(
+		&target_fea_casemanager, target_densities.dim_x, target_densities.dim_y, &densities, fea_casemanager
+	);
+	fea_casemanager.max_stress_threshold = max_stress_threshold;
+	no_cells = densities.size;
+	if (screening_fraction < 1.0) proxy = fem::CoarseProxy2D(&fea_casemanager, &densities);
+	if (in_process_fea) init_solver();
+	fea_cache.set_context(&fea_casemanager, in_process_fea ? "in-process" : "elmer");
+	cout << "Set fidelity level to " << level + 1 << " / " << no_fidelity_levels << " (" << densities.dim_x << " x "
+		<< densities.dim_y << " cells).\n";
+}
+
+/*
+Move the population to the next level of the multi-fidelity schedule. Each individual is upsampled to the finer grid,
+repaired and re-evaluated, since fitnesses obtained at different resolutions are not comparable.
+*/
+void Evolver::refine_population(bool verbose) {
+	set_fidelity_level(fidelity_level + 1);
+	cout << "Refining population...\n";
+	for (int i = 0; i < population.size(); i++) {
+		evo::Individual2d refined(&densities);
+		population[i].resample_to(&refined);
+		if (!refined.repair()) {
+			cout << "- WARNING: Individual " << i + 1 << " is invalid after refinement. Replacing it with the input shape.\n";
+			refined.copy_from(&densities);
+		}
+		string folder = iteration_folder + help::add_padding("/refined_individual_", i + 1) + to_string(i + 1);
+		IO::create_folder_if_not_exists(folder);
+		population[i].delete_arrays();
+		population[i] = refined;
+		export_individual(&population[i], folder);
+	}
+
+	if (in_process_fea) evaluate_in_process(0, pop_size, verbose);
+	else {
+		wait_for_evaluations(verbose);
+		cout << "Finished reading FEA results for refined population.\n";
+	}
+
+	// Restart fitness bookkeeping at the new resolution
+	fitnesses_map.clear();
+	fitness_time_series.clear();
+	best_fitness = -INFINITY;
+	evaluate_fitnesses(0);
+	if (screening_fraction < 1.0) {
+		for (auto& indiv : population) {
+			if (indiv.fitness == -INFINITY) continue;
+			proxy.calibrate(proxy.estimate_max_stress(&indiv, false), indiv.fea_results.max);
+		}
+	}
+}
+
+void Evolver::init_solver() {
+	vector<fem::LoadCase> load_cases;
+	fem::create_load_cases(&fea_casemanager, densities.dim_x, densities.dim_y, densities.cell_size, load_cases);
+	fem::Material material = fem::parse_material(&fea_casemanager.active_cases[0]);
+	solver = fem::GridSolver2D(densities.dim_x, densities.dim_y, densities.cell_size, material, load_cases);
+}
+
+// Run FEA on the given range of the population using the in-process solver
+void Evolver::evaluate_in_process(int offset, int count, bool verbose) {
+	for (int i = offset; i < offset + count; i++) {
+		if (population[i].fitness_is_cached) continue;
+		if (!solver.solve(&population[i])) {
+			cout << "WARNING: Setting fitness to -infinity for individual " << to_string(i - offset) << " because FEA failed.\n";
+			population[i].fitness = -INFINITY;
+			continue;
+		}
+		solver.write_results(&population[i], fea_casemanager.mechanical_constraint);
+		if (mutation_method == "sensitivity") {
+			solver.get_sensitivities(&population[i], fea_casemanager.mechanical_constraint, population[i].fea_results.sensitivities);
+		}
+		if (verbose && (count < 10 || (i - offset + 1) % (count / 5) == 0))
+			cout << "- Finished FEA for individual " << i - offset + 1 << " / " << count << "\n";
+	}
+}
+
+// Set the FEA context of the cache and load previously cached results from disk (if a cache file was given)
+void Evolver::init_fea_cache() {
+	fea_cache.set_context(&fea_casemanager, in_process_fea ? "in-process" : "elmer");
+	if (fea_cache.load()) cout << "Loaded " << fea_cache.size() << " cached FEA results from " << fea_cache.path << endl;
+}
+
+// Look up the FEA results of the given individual's density distribution in the cache. On a hit, they are copied into the
+// individual's FEA results.
+bool Evolver::fetch_cached_results(evo::Individual2d* individual) {
+	individual->fitness_is_cached = fea_cache.fetch(
+		fea_cache.get_key(individual->get_values(), individual->size, individual->dim_x, individual->dim_y), individual->fea_results
+	);
+	return individual->fitness_is_cached;
+}
+
+/*
+Run FEA for the given individual if its folder has no results files, which is the case if its FEA results were taken from
+the cache (see export_individual). Its FEA results are not reloaded, since they are already known.
+*/
+void Evolver::create_missing_results_files(evo::Individual2d* individual) {
+	if (in_process_fea) return;
+	vector<string> vtk_paths;
+	msh::get_vtk_paths(&fea_casemanager, individual->output_folder, vtk_paths);
+	bool complete = true;
+	for (auto& vtk_path : vtk_paths) complete = complete && IO::file_exists(vtk_path);
+	if (complete) return;
+	cout << "- Running FEA for the best individual, whose FEA results were taken from the cache.\n";
+	IO::create_folder_if_not_exists(individual->output_folder);
+	create_individual_mesh(individual);
+	create_sif_files(individual, &individual->fe_mesh);
+	for (auto& fea_case : fea_casemanager.active_cases) {
+		run_FEA_case(individual->output_folder, fea_case.name, &fea_casemanager, fea_retry_policy, solver_processes.get());
+	}
+}
+
+// Finish the archive of the previous iteration (if any) and start the archive of the current iteration
+void Evolver::open_archive() {
+	if (!archive_results) return;
+	if (archive.is_open()) archive.finish();
+	vector<string> case_names;
+	for (auto& fea_case : fea_casemanager.active_cases) case_names.push_back(fea_case.name);
+	archive.create(archive_folder + "/" + iteration_name + ".bin", case_names, fea_casemanager.mechanical_constraint);
+}
+
+void Evolver::archive_individual(evo::Individual2d* individual, double fitness) {
+	phys::ResultsArchive::Record record;
+	record.name = individual->output_folder.substr(individual->output_folder.find_last_of('/') + 1);
+	record.iteration = individual->iteration;
+	record.dim_x = individual->dim_x;
+	record.dim_y = individual->dim_y;
+	record.fitness = fitness;
+	record.min = individual->fea_results.min;
+	record.max = individual->fea_results.max;
+	record.fitness_is_proxy = individual->fitness_is_proxy;
+	record.fitness_is_cached = individual->fitness_is_cached;
+	record.set_densities(individual->get_values(), individual->size);
+	record.case_fields = move(individual->fea_results.case_fields);
+	archive.append(&record);
+}
+
+/*
+Queue the superposition of the given individual's FEA results, built from the copies of its results files in <target_folder>.
+Superpositions are only available after FEA with Elmer, and not for individuals whose results were taken from the cache.
+*/
+void Evolver::queue_superposition(evo::Individual2d* individual, string target_folder) {
+	if (in_process_fea) return;
+	phys::SuperpositionReference reference;
+	msh::get_vtk_paths(&fea_casemanager, target_folder, reference.filenames);
+	for (auto& filename : reference.filenames) if (!IO::file_exists(filename)) return;
+	reference.dim_x = individual->dim_x;
+	reference.dim_y = individual->dim_y;
+	reference.cell_size = individual->cell_size;
+	reference.offset = Vector2d(mesh.offset(0), mesh.offset(1));
+	reference.outfile = target_folder + "/SuperPosition." + fea_casemanager.results_format;
+	superposition_queue->push(reference);
+}
+
+// Write all superpositions that have not been written yet
+void Evolver::write_pending_superpositions() {
+	int no_pending = superposition_queue->size();
+	if (no_pending) cout << "Writing " << no_pending << " pending superposition(s)...\n";
+	superposition_queue->flush();
+}
+
 void Evolver::cleanup() {
 	if (iteration_number < 2) return;
 	if (help::is_in(&iterations_with_fea_failure, (iteration_number - 1))) return; // Skip removal of iterations with FEA failure
@@ -735,6 +1479,7 @@ void Evolver::cleanup() {
 }
 
 void Evolver::evolve() {
+	if (superposition_mode == "background") superposition_queue->start();
 	do_setup();
 	start_time = time(0);
 	bool mutation_boost = false;
@@ -744,9 +1489,18 @@ void Evolver::evolve() {
 		cout << "\nStarting iteration " << iteration_number << "...\n";
 		if (fea_casemanager.dynamic) update_objective_function();
 		create_iteration_directories(iteration_number);
-		create_children();
-		evaluate_fitnesses(pop_size);
-		do_selection();
+		iterations_at_fidelity_level++;
+		bool fitness_stalled = abs(fitness_time_derivative) < refinement_trigger;
+		if (fidelity_level < no_fidelity_levels - 1 && iterations_at_fidelity_level > min_iterations_per_fidelity_level && fitness_stalled) {
+			refine_population();
+		}
+		if (evolution_mode == "steady-state") run_steady_state_epoch();
+		else {
+			create_children();
+			evaluate_fitnesses(pop_size);
+			do_selection();
+		}
+		if (island_channel && iteration_number % migration_interval == 0) migrate();
 		collect_stats();
 		export_stats(iteration_name);
 		cleanup();
@@ -786,5 +1540,9 @@ void Evolver::evolve() {
 			mutation_boost = false;
 		}
 	}
+	if (archive.is_open()) archive.finish();
+	superposition_queue->stop();
+	write_pending_superpositions();
+	if (fea_cache.save()) cout << "Saved " << fea_cache.size() << " cached FEA results to " << fea_cache.path << endl;
 }
 
@@ -6,11 +6,118 @@
 #include <algorithm>
 #include <map>
 #include <functional>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "helpers.h"
 #include "optimizerBase.h"
 #include "individual.h"
+#include "fem.h"
+#include "workers.h"
+#include "islands.h"
+#include "diversity.h"
 
 
+/*
+Queue of superpositions (see phys::SuperpositionReference) that are written lazily, so that VTK serialization does not
+add to the latency of the main loop. Once started, a low-priority background thread writes superpositions as they are
+queued. Superpositions that are still pending are written by flush().
+*/
+class SuperpositionQueue {
+public:
+	SuperpositionQueue() = default;
+	~SuperpositionQueue() { stop(); }
+	void push(phys::SuperpositionReference reference);
+	void start();
+	void stop();
+	void flush();
+	int size();
+private:
+	void work();
+	bool pop(phys::SuperpositionReference& reference);
+	deque<phys::SuperpositionReference> pending;
+	mutex queue_mutex;
+	condition_variable queue_condition;
+	thread worker;
+	bool stopping = false;
+};
+
+/*
+Bookkeeping for the stages an individual passes through while it is evaluated on the worker pool: creation (including
+repair), export of its FE mesh and case files, solving of its FEA cases and loading of the results. The number of
+individuals in the export, solve and load stages is bounded. Once the bound is reached, the creation stage blocks until an
+individual has been loaded, so that exported meshes do not pile up ahead of the solvers. The time spent in each stage is
+accumulated to report the stages' throughput.
+*/
+class EvaluationPipeline {
+public:
+	enum Stage { Create, Export, Solve, Load, NO_STAGES };
+	EvaluationPipeline() = default;
+	void set_capacity(int _capacity) { capacity = max(1, _capacity); }
+	void enter();
+	void leave();
+	void record(Stage stage, double seconds, int count = 1);
+	double get_throughput(Stage stage);
+	double get_stall_time();
+	void reset_stats();
+	int capacity = 1;
+private:
+	mutex pipeline_mutex;
+	condition_variable pipeline_condition;
+	int no_in_flight = 0;
+	double busy_time[NO_STAGES] = {};
+	int no_processed[NO_STAGES] = {};
+	double stall_time = 0; // Time the creation stage was blocked because the pipeline was full
+};
+
+// Settings of the evaluation of individuals on the worker pool
+struct EvaluationOptions {
+	bool in_process_fea = false; // Evaluate individuals with fem::GridSolver2D instead of Elmer
+	int no_threads = 0; // Number of worker threads. 0 uses all hardware threads.
+	int max_solver_processes = 0; // Maximum number of concurrent Elmer processes. 0 uses half the hardware threads.
+	int pipeline_capacity = 0; // Maximum number of individuals being evaluated at once. 0 uses twice the number of worker threads.
+	phys::RetryPolicy retry_policy;
+	bool archive_results = false; // Record evaluated individuals in per-iteration results archives instead of keeping their folders
+	string superposition_mode = "background"; // When superpositions of new best individuals are written: "background" or "end"
+};
+
+// Settings of the pre-screening of children with a coarse proxy model (see fem::CoarseProxy2D)
+struct ScreeningOptions {
+	float fraction = 1.0; // Fraction of children sent to full FEA after pre-screening. 1.0 disables screening.
+	int audit_size = 1; // Number of screened-out children that are nevertheless fully evaluated, to measure the screening error
+};
+
+// Settings of the multi-fidelity schedule
+struct FidelityOptions {
+	int no_levels = 1; // Number of grid resolutions, starting at dim_x / 2^(no_levels - 1)
+	float refinement_trigger = 0.001; // Refine once the fitness time derivative drops below this value
+	int min_iterations_per_level = 10;
+};
+
+// Settings of the cache of FEA results (see phys::FEAResultsCache)
+struct CacheOptions {
+	int size = 0; // Maximum number of cached FEA results. 0 disables the cache.
+	string file = ""; // If set, cached FEA results are loaded from and saved to this file
+};
+
+// Settings of steady-state evolution (see Evolver::run_steady_state_epoch)
+struct SteadyStateOptions {
+	string evolution_mode = "generational"; // "generational" or "steady-state"
+	string replacement_method = "worst"; // Replacement of the "worst" individual, or the loser of a "tournament"
+	int replacement_tournament_size = 2;
+};
+
+// Settings of the migration between islands (see Evolver::join_islands)
+struct IslandOptions {
+	int migration_interval = 10; // Number of iterations between migrations
+	int no_migrants = 2; // Number of individuals sent to the next island per migration
+	int base_port = 50000;
+	vector<string> hosts; // Host of each island. If empty, all islands run on localhost.
+	double migration_timeout = 3600; // Seconds to wait for the migrants of the previous island
+};
+
 class Evolver : public OptimizerBase {
 public:
 	Evolver() = default;
@@ -18,7 +125,9 @@ public:
 		phys::FEACaseManager _fea_manager, msh::SurfaceMesh _mesh, string _base_folder, int _pop_size, int _no_static_iterations_trigger,
 		float _mutation_rate_level0, float _mutation_rate_level1, grd::Densities2d _starting_densities, double _variation_trigger, int _max_iterations,
 		int _max_iterations_without_change, bool _export_msh, bool _verbose, float _initial_perturb_level0, float _initial_perturb_level1,
-		string _crossover_method, float _stress_fitness_influence
+		string _crossover_method, float _stress_fitness_influence, string _mutation_method = "uniform",
+		EvaluationOptions evaluation = {}, ScreeningOptions screening = {}, FidelityOptions fidelity = {}, CacheOptions cache = {},
+		SteadyStateOptions steady_state = {}
 	) : OptimizerBase(
 		_fea_manager, _mesh, _base_folder, _starting_densities, _max_iterations, _export_msh, _verbose)
 	{
@@ -34,31 +143,84 @@ public:
 		best_solutions_folder = output_folder + "/best_solutions";
 		best_individuals_images_folder = image_folder + "/best_individuals";
 		stress_fitness_influence = _stress_fitness_influence;
+		mutation_method = _mutation_method;
+		in_process_fea = evaluation.in_process_fea;
+		no_threads = evaluation.no_threads;
+		max_solver_processes = evaluation.max_solver_processes;
+		pipeline_capacity = evaluation.pipeline_capacity;
+		fea_retry_policy = evaluation.retry_policy;
+		archive_results = evaluation.archive_results;
+		archive_folder = output_folder + "/archive";
+		if (archive_results) IO::create_folder_if_not_exists(archive_folder);
+		superposition_mode = evaluation.superposition_mode;
+		screening_fraction = screening.fraction;
+		screening_audit_size = screening.audit_size;
+		no_fidelity_levels = fidelity.no_levels;
+		refinement_trigger = fidelity.refinement_trigger;
+		min_iterations_per_fidelity_level = fidelity.min_iterations_per_level;
+		fea_cache = phys::FEAResultsCache(cache.size, cache.file);
+		evolution_mode = steady_state.evolution_mode;
+		replacement_method = steady_state.replacement_method;
+		replacement_tournament_size = steady_state.replacement_tournament_size;
 		IO::create_folder_if_not_exists(best_individuals_images_folder);
 		IO::create_folder_if_not_exists(best_solutions_folder);
 		img::write_distribution_to_image(densities, image_folder + "/starting_shape.jpg");
 	}
-	void do_2x_crossover(evo::Individual2d parent1, evo::Individual2d parent2, evo::Individual2d child1, evo::Individual2d child2);
-	void do_ux_crossover(evo::Individual2d parent1, evo::Individual2d parent2, evo::Individual2d child1, evo::Individual2d child2);
+	void do_2x_crossover(evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2);
+	void do_ux_crossover(evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2);
+	void do_block_crossover(evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2);
+	void do_spatial_crossover(evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2);
+	void do_masked_crossover(
+		evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2,
+		vector<uint64_t>* mask
+	);
+	void do_crossover(evo::Individual2d& parent1, evo::Individual2d& parent2, evo::Individual2d& child1, evo::Individual2d& child2);
 	void do_2d_mutation(evo::Individual2d& densities, float _mutation_rate_level0, float _mutation_rate_level1);
-	void create_valid_child_densities(vector<evo::Individual2d>* parents, vector<evo::Individual2d>& children);
+	void do_sensitivity_mutation(
+		evo::Individual2d& individual, vector<double>* sensitivities, float _mutation_rate_level0, float _mutation_rate_level1
+	);
+	bool create_valid_child_densities(vector<evo::Individual2d>* parents, vector<evo::Individual2d>& children);
+	uint64_t get_child_stream(int pair);
 	void init_population(bool verbose = true);
 	void evolve();
 	void do_setup();
 	void create_children(bool verbose = true);
-	void evaluate_fitnesses(int offset, bool do_FEA = false, bool verbose = true);
+	void evaluate_fitnesses(int offset, bool do_FEA = false, bool verbose = true, bool rescore = false);
+	double evaluate_fitness(evo::Individual2d* individual);
 	void do_selection();
+	void export_best_solution();
+	void run_steady_state_epoch(bool verbose = true);
+	bool replace_individual(evo::Individual2d* child, double fitness);
+	bool join_islands(int _island, int _no_islands, IslandOptions options = {});
+	void migrate(bool verbose = true);
 	void create_iteration_directories(int iteration);
 	virtual void write_densities_to_image(bool verbose = false);
 	bool termination_condition_reached();
 	void choose_parents(vector<evo::Individual2d>& parents, vector<evo::Individual2d>* _population);
 	void create_individual_mesh(evo::Individual2d* individual, bool verbose = false);
-	void export_individual(evo::Individual2d* individual, string folder);
+	void export_individual(evo::Individual2d* individual, string folder, function<void()> on_evaluated = nullptr);
+	void submit_evaluation(evo::Individual2d* individual, function<void()> on_evaluated = nullptr);
+	void wait_for_evaluations(bool verbose = false);
 	void export_stats(string iteration_name, bool verbose = false);
 	void collect_stats();
 	void cleanup();
 	void update_objective_function();
 	void create_single_individual(bool verbose = false);
+	double get_fitness(double max_stress, double relative_area);
+	double get_fitness(evo::Individual2d* individual);
+	void screen_children(bool verbose = false);
+	void update_screening_stats();
+	void set_fidelity_level(int level);
+	void refine_population(bool verbose = false);
+	void init_solver();
+	void evaluate_in_process(int offset, int count, bool verbose = false);
+	void init_fea_cache();
+	bool fetch_cached_results(evo::Individual2d* individual);
+	void create_missing_results_files(evo::Individual2d* individual);
+	void open_archive();
+	void archive_individual(evo::Individual2d* individual, double fitness);
+	void queue_superposition(evo::Individual2d* individual, string target_folder);
+	void write_pending_superpositions();
 	virtual void export_meta_parameters(vector<string>* _ = 0) override;
 	vector<evo::Individual2d> population;
 private:
@@ -78,6 +240,9 @@ private:
 	double best_fitness = -INFINITY;
 	double minimum_stress = INFINITY;
 	float variation = 0;
+	int exact_diversity_limit = 256; // Larger populations have their variation estimated (see diversity_estimate)
+	string diversity_estimate = "sample"; // "sample" (distances to random others) or "minhash" (comparison of sketches)
+	int no_diversity_samples = 64; // Number of random others (sample) or sketch bins (minhash) per individual
 	float stress_fitness_influence = 0;
 	int iterations_since_fitness_change = 0;
 	int max_iterations_without_change = 1;
@@ -87,7 +252,49 @@ private:
 	string current_best_solution_folder;
 	string best_solutions_folder;
 	string best_individuals_images_folder;
-	string crossover_method;
+	string crossover_method; // "2x" (2-point), "ux" (uniform), "block" or "spatial" (rectangle or circle patch)
+	int crossover_block_size = 4; // Width and height (in cells) of the blocks exchanged by block crossover
 	double fitness_mean, fitness_stdev, relative_area_mean, relative_area_stdev, relative_max_stress_mean, relative_max_stress_stdev;
 	vector<int> iterations_with_fea_failure;
+	float screening_fraction = 1.0; // Fraction of children sent to full FEA after pre-screening. 1.0 disables screening.
+	int screening_audit_size = 1; // Number of screened-out children that are nevertheless fully evaluated, to measure the screening error
+	fem::CoarseProxy2D proxy;
+	double screening_cutoff = -INFINITY;
+	vector<int> audited_children;
+	float screening_error = 0;
+	int no_fidelity_levels = 1; // Number of grid resolutions in the multi-fidelity schedule. Each coarser level halves dim_x.
+	int fidelity_level = 0;
+	float refinement_trigger = 0.001; // Refine once the fitness time derivative drops below this value
+	int min_iterations_per_fidelity_level = 10;
+	int iterations_at_fidelity_level = 0;
+	grd::Densities2d target_densities;
+	phys::FEACaseManager target_fea_casemanager;
+	bool in_process_fea = false; // Evaluate individuals with fem::GridSolver2D instead of Elmer
+	string mutation_method = "uniform"; // "uniform" or "sensitivity" (requires in-process FEA)
+	fem::GridSolver2D solver;
+	phys::FEAResultsCache fea_cache; // FEA results of previously evaluated density distributions
+	bool archive_results = false; // Record each evaluated individual in a per-iteration results archive (see phys::ResultsArchive) instead of keeping its folder
+	string archive_folder;
+	phys::ResultsArchive archive;
+	string superposition_mode = "background"; // When superpositions of new best individuals are written: "background" or "end" (of the run)
+	shared_ptr<SuperpositionQueue> superposition_queue = make_shared<SuperpositionQueue>();
+	int no_threads = 0; // Number of worker threads used for FE mesh export, FEA and results loading. 0 uses all hardware threads.
+	shared_ptr<WorkerPool> pool;
+	int max_solver_processes = 0; // Maximum number of concurrent Elmer processes. 0 uses half the hardware threads.
+	shared_ptr<ProcessLimiter> solver_processes = make_shared<ProcessLimiter>();
+	phys::RetryPolicy fea_retry_policy;
+	int pipeline_capacity = 0; // Maximum number of individuals being evaluated at once. 0 uses twice the number of worker threads.
+	shared_ptr<EvaluationPipeline> pipeline = make_shared<EvaluationPipeline>();
+	string evolution_mode = "generational"; // "generational" or "steady-state" (see run_steady_state_epoch)
+	string replacement_method = "worst"; // Steady-state replacement: "worst" or "tournament"
+	int replacement_tournament_size = 2;
+	int no_evaluations = 0;
+	int child_retry_budget = 1000; // Maximum number of attempts to create a valid pair of children
+	shared_ptr<CompletionQueue<int>> evaluated_children = make_shared<CompletionQueue<int>>();
+	int island = 0; // Index of this evolver in a ring of islands (see join_islands)
+	int no_islands = 1;
+	int migration_interval = 10; // Number of iterations between migrations
+	int no_migrants = 2; // Number of individuals sent to the next island per migration
+	double migration_timeout = 3600; // Seconds to wait for the migrants of the previous island
+	shared_ptr<IslandChannel> island_channel;
 };
@@ -0,0 +1,623 @@
+#pragma once
+#include "fem.h"
+
+
+using namespace fessga;
+
+
+// Read the material parameters from the given case's .sif content
+fem::Material fem::parse_material(phys::FEACase* fea_case) {
+    Material material;
+    for (auto& section : fea_case->sections) {
+        vector<string> lines;
+        help::split(section, "\n", lines);
+        for (auto& line : lines) {
+            vector<string> split_line;
+            help::split(line, " = ", split_line);
+            if (split_line.size() < 2) continue;
+            string key = help::replace_occurrences(split_line[0], " ", "");
+            try {
+                if (key == "Youngsmodulus") material.youngs_modulus = stod(split_line[1]);
+                else if (key == "Poissonratio") material.poisson_ratio = stod(split_line[1]);
+            }
+            catch (const std::invalid_argument&) {
+                cout << "fem: WARNING: Unable to parse material parameter '" << line << "'\n";
+            }
+            if (key == "PlaneStress") material.plane_stress = help::is_in(split_line[1], "True");
+        }
+    }
+    return material;
+}
+
+// Read the 'Force <i>' and 'Displacement <i>' values of each boundary condition in the given case. The section following
+// each boundary condition's 'Target Boundaries' line contains the remainder of that boundary condition's definition.
+void fem::parse_boundary_values(phys::FEACase* fea_case, map<string, map<string, double>>& boundary_values) {
+    for (int i = 0; i < fea_case->names.size(); i++) {
+        string bound_name = fea_case->names[i];
+        vector<string> lines;
+        help::split(fea_case->sections[i + 1], "\n", lines);
+        for (auto& line : lines) {
+            if (help::is_in(line, "End")) break;
+            vector<string> split_line;
+            help::split(line, " = ", split_line);
+            if (split_line.size() < 2) continue;
+            string key = split_line[0];
+            while (key.size() && key[0] == ' ') key.erase(0, 1);
+            if (key.rfind("Force", 0) != 0 && key.rfind("Displacement", 0) != 0) continue;
+            try {
+                boundary_values[bound_name][key] = stod(split_line[1]);
+            }
+            catch (const std::invalid_argument&) {
+                cout << "fem: WARNING: Unable to parse boundary value '" << line << "' of boundary condition " << bound_name << endl;
+            }
+        }
+    }
+}
+
+fem::LoadCase::LoadCase(phys::FEACase* fea_case, int dim_x, int dim_y, Vector2d cell_size) {
+    name = fea_case->name;
+    map<string, map<string, double>> boundary_values;
+    parse_boundary_values(fea_case, boundary_values);
+    for (auto& [bound_name, lines] : fea_case->bound_cond_lines) {
+        map<string, double>* values = &boundary_values[bound_name];
+        for (auto& line : lines) {
+            int node1_x = line.first / (dim_y + 1); int node1_y = line.first % (dim_y + 1);
+            int node2_x = line.second / (dim_y + 1); int node2_y = line.second % (dim_y + 1);
+            double length = abs(node1_x - node2_x) * cell_size(0) + abs(node1_y - node2_y) * cell_size(1);
+            for (int component = 0; component < 2; component++) {
+                string displacement_key = "Displacement " + to_string(component + 1);
+                string force_key = "Force " + to_string(component + 1);
+                if (values->find(displacement_key) != values->end()) {
+                    if (values->at(displacement_key) != 0) cout << "fem: WARNING: Non-zero prescribed displacement on boundary "
+                        << bound_name << " is not supported. Fixing the displacement at 0 instead.\n";
+                    fixed_dofs.push_back(line.first * 2 + component);
+                    fixed_dofs.push_back(line.second * 2 + component);
+                }
+                else if (values->find(force_key) != values->end()) {
+                    // Forces are given per unit length of the boundary; distribute each line's share over its two nodes
+                    double nodal_force = values->at(force_key) * length * 0.5;
+                    nodal_forces[line.first * 2 + component] += nodal_force;
+                    nodal_forces[line.second * 2 + component] += nodal_force;
+                }
+            }
+        }
+    }
+    sort(fixed_dofs.begin(), fixed_dofs.end());
+    fixed_dofs.erase(unique(fixed_dofs.begin(), fixed_dofs.end()), fixed_dofs.end());
+    for (auto& dof : fixed_dofs) nodal_forces.erase(dof);
+}
+
+void fem::create_load_cases(
+    phys::FEACaseManager* fea_casemanager, int dim_x, int dim_y, Vector2d cell_size, vector<LoadCase>& load_cases
+) {
+    for (auto& fea_case : fea_casemanager->active_cases) {
+        load_cases.push_back(LoadCase(&fea_case, dim_x, dim_y, cell_size));
+    }
+}
+
+void fem::get_stiffness_factors(grd::Densities2d* densities, vector<double>& factors, double void_stiffness) {
+    factors.resize(densities->size);
+    for (int i = 0; i < densities->size; i++) factors[i] = densities->at(i) ? 1.0 : void_stiffness;
+}
+
+fem::GridSolver2D::GridSolver2D(
+    int _dim_x, int _dim_y, Vector2d _cell_size, Material _material, vector<LoadCase> _load_cases, double _void_stiffness
+) {
+    dim_x = _dim_x; dim_y = _dim_y;
+    cell_size = _cell_size;
+    material = _material;
+    load_cases = _load_cases;
+    void_stiffness = _void_stiffness;
+    no_nodes = (dim_x + 1) * (dim_y + 1);
+    no_dofs = no_nodes * 2;
+    compute_element_stiffness();
+
+    // Group load cases by their fixed degrees of freedom
+    for (int i = 0; i < load_cases.size(); i++) {
+        Factorization* factorization = 0;
+        for (auto& _factorization : factorizations) {
+            if (load_cases[_factorization.cases[0]].fixed_dofs == load_cases[i].fixed_dofs) {
+                factorization = &_factorization; break;
+            }
+        }
+        if (factorization) {
+            factorization->cases.push_back(i);
+            continue;
+        }
+        Factorization new_factorization;
+        new_factorization.cases = { i };
+        new_factorization.free_index = vector<int>(no_dofs, 0);
+        for (auto& dof : load_cases[i].fixed_dofs) new_factorization.free_index[dof] = -1;
+        for (int dof = 0; dof < no_dofs; dof++) {
+            if (new_factorization.free_index[dof] == -1) continue;
+            new_factorization.free_index[dof] = new_factorization.free_dofs.size();
+            new_factorization.free_dofs.push_back(dof);
+        }
+        factorizations.push_back(new_factorization);
+    }
+    displacements = vector<VectorXd>(load_cases.size(), VectorXd::Zero(no_dofs));
+}
+
+// Compute the stiffness matrix of a bilinear quad element with the dimensions of a single cell (2x2 Gauss quadrature)
+void fem::GridSolver2D::compute_element_stiffness() {
+    double E = material.youngs_modulus;
+    double nu = material.poisson_ratio;
+    if (material.plane_stress) {
+        constitutive << 1, nu, 0, nu, 1, 0, 0, 0, (1 - nu) / 2;
+        constitutive *= E / (1 - nu * nu);
+    }
+    else {
+        constitutive << 1 - nu, nu, 0, nu, 1 - nu, 0, 0, 0, (1 - 2 * nu) / 2;
+        constitutive *= E / ((1 + nu) * (1 - 2 * nu));
+    }
+
+    // Local node order: (x, y), (x + 1, y), (x + 1, y + 1), (x, y + 1)
+    double xi_signs[4] = { -1, 1, 1, -1 };
+    double eta_signs[4] = { -1, -1, 1, 1 };
+    auto get_strain_displacement = [&](double xi, double eta) {
+        Matrix<double, 3, 8> B = Matrix<double, 3, 8>::Zero();
+        for (int i = 0; i < 4; i++) {
+            double dN_dx = xi_signs[i] * (1 + eta_signs[i] * eta) * 0.25 * (2.0 / cell_size(0));
+            double dN_dy = eta_signs[i] * (1 + xi_signs[i] * xi) * 0.25 * (2.0 / cell_size(1));
+            B(0, i * 2) = dN_dx;
+            B(1, i * 2 + 1) = dN_dy;
+            B(2, i * 2) = dN_dy;
+            B(2, i * 2 + 1) = dN_dx;
+        }
+        return B;
+    };
+    double gauss_point = 1.0 / sqrt(3.0);
+    double jacobian_determinant = cell_size(0) * cell_size(1) * 0.25;
+    element_stiffness.setZero();
+    for (int i = 0; i < 4; i++) {
+        Matrix<double, 3, 8> B = get_strain_displacement(xi_signs[i] * gauss_point, eta_signs[i] * gauss_point);
+        element_stiffness += B.transpose() * constitutive * B * jacobian_determinant;
+    }
+    center_strain_displacement = get_strain_displacement(0, 0);
+}
+
+void fem::GridSolver2D::get_element_dofs(int cell, int* dofs) {
+    int x = cell / dim_y;
+    int y = cell % dim_y;
+    int nodes[4] = {
+        x * (dim_y + 1) + y, (x + 1) * (dim_y + 1) + y, (x + 1) * (dim_y + 1) + y + 1, x * (dim_y + 1) + y + 1
+    };
+    for (int i = 0; i < 4; i++) {
+        dofs[i * 2] = nodes[i] * 2;
+        dofs[i * 2 + 1] = nodes[i] * 2 + 1;
+    }
+}
+
+void fem::GridSolver2D::expand_solution(Factorization* factorization, int load_case, VectorXd& reduced_solution) {
+    displacements[load_case].setZero();
+    for (int i = 0; i < factorization->free_dofs.size(); i++) {
+        displacements[load_case][factorization->free_dofs[i]] = reduced_solution[i];
+    }
+}
+
+// Assemble and factorize the reduced stiffness matrix of each group of load cases, and solve for the base displacements
+bool fem::GridSolver2D::factorize(vector<double>* stiffness_factors) {
+    int no_cells = dim_x * dim_y;
+    int dofs[8];
+    for (auto& factorization : factorizations) {
+        vector<Triplet<double>> triplets;
+        triplets.reserve(no_cells * 64);
+        for (int cell = 0; cell < no_cells; cell++) {
+            get_element_dofs(cell, dofs);
+            for (int i = 0; i < 8; i++) {
+                int row = factorization.free_index[dofs[i]];
+                if (row == -1) continue;
+                for (int j = 0; j < 8; j++) {
+                    int col = factorization.free_index[dofs[j]];
+                    if (col == -1) continue;
+                    triplets.push_back(Triplet<double>(row, col, stiffness_factors->at(cell) * element_stiffness(i, j)));
+                }
+            }
+        }
+        int no_free_dofs = factorization.free_dofs.size();
+        SparseMatrix<double> stiffness(no_free_dofs, no_free_dofs);
+        stiffness.setFromTriplets(triplets.begin(), triplets.end());
+        factorization.ldlt = make_shared<SimplicialLDLT<SparseMatrix<double>>>(stiffness);
+        if (factorization.ldlt->info() != Success) {
+            cout << "fem: ERROR: Factorization of the stiffness matrix failed.\n";
+            return false;
+        }
+        factorization.update_columns.clear();
+        factorization.update_rows.clear();
+        factorization.update_basis.clear();
+        factorization.base_solutions.clear();
+        for (auto& load_case : factorization.cases) {
+            VectorXd forces = VectorXd::Zero(no_free_dofs);
+            for (auto& [dof, force] : load_cases[load_case].nodal_forces) {
+                if (factorization.free_index[dof] != -1) forces[factorization.free_index[dof]] += force;
+            }
+            VectorXd solution = factorization.ldlt->solve(forces);
+            factorization.base_solutions.push_back(solution);
+            expand_solution(&factorization, load_case, solution);
+        }
+    }
+    base_factors = *stiffness_factors;
+    last_update_rank = 0;
+    last_solve_was_incremental = false;
+    return true;
+}
+
+/*
+Apply the stiffness change of the given cells as a low-rank update to the existing factorization (Woodbury identity).
+With K the factorized stiffness, P the selection of affected dofs and D the assembled stiffness change on those dofs:
+    (K + P D P^T)^-1 f = u0 - Z (I + D P^T Z)^-1 D P^T u0,    where u0 = K^-1 f and Z = K^-1 P.
+This form remains valid when D is singular, which it always is (element stiffness matrices have rigid body modes).
+Returns false if the rank of the update exceeds the maximum update rank, in which case a full solve should be done instead.
+*/
+bool fem::GridSolver2D::apply_low_rank_update(vector<double>* stiffness_factors, vector<int>& changed_cells) {
+    int dofs[8];
+    vector<int> affected_dofs;
+    for (auto& cell : changed_cells) {
+        get_element_dofs(cell, dofs);
+        for (int i = 0; i < 8; i++) affected_dofs.push_back(dofs[i]);
+    }
+    sort(affected_dofs.begin(), affected_dofs.end());
+    affected_dofs.erase(unique(affected_dofs.begin(), affected_dofs.end()), affected_dofs.end());
+    if (affected_dofs.size() > get_max_update_rank()) return false;
+
+    for (auto& factorization : factorizations) {
+        // Collect the affected dofs that are part of the reduced system
+        vector<int> update_dofs;
+        map<int, int> local_index;
+        for (auto& dof : affected_dofs) {
+            if (factorization.free_index[dof] == -1) continue;
+            local_index[dof] = update_dofs.size();
+            update_dofs.push_back(dof);
+        }
+        int rank = update_dofs.size();
+        int no_free_dofs = factorization.free_dofs.size();
+        factorization.update_rows.clear();
+        factorization.update_basis.clear();
+        if (rank == 0) {
+            for (int i = 0; i < factorization.cases.size(); i++) {
+                expand_solution(&factorization, factorization.cases[i], factorization.base_solutions[i]);
+            }
+            continue;
+        }
+
+        // Obtain the columns of Z = K^-1 P. Columns are cached, since the set of affected dofs only grows between
+        // successive refactorizations. Z is not assembled; the update refers to the cached columns.
+        for (int i = 0; i < rank; i++) {
+            auto column = factorization.update_columns.find(update_dofs[i]);
+            if (column == factorization.update_columns.end()) {
+                VectorXd unit_vector = VectorXd::Zero(no_free_dofs);
+                unit_vector[factorization.free_index[update_dofs[i]]] = 1.0;
+                VectorXd column_values = factorization.ldlt->solve(unit_vector);
+                column = factorization.update_columns.insert(pair(update_dofs[i], column_values)).first;
+            }
+            factorization.update_basis.push_back(&column->second);
+        }
+
+        // Assemble the stiffness change D on the affected dofs
+        MatrixXd D = MatrixXd::Zero(rank, rank);
+        for (auto& cell : changed_cells) {
+            double change = stiffness_factors->at(cell) - base_factors[cell];
+            get_element_dofs(cell, dofs);
+            for (int i = 0; i < 8; i++) {
+                if (factorization.free_index[dofs[i]] == -1) continue;
+                for (int j = 0; j < 8; j++) {
+                    if (factorization.free_index[dofs[j]] == -1) continue;
+                    D(local_index[dofs[i]], local_index[dofs[j]]) += change * element_stiffness(i, j);
+                }
+            }
+        }
+
+        // Compute P^T Z and factorize the small (rank x rank) capacitance matrix
+        for (auto& dof : update_dofs) factorization.update_rows.push_back(factorization.free_index[dof]);
+        MatrixXd PtZ(rank, rank);
+        for (int i = 0; i < rank; i++) {
+            for (int j = 0; j < rank; j++) PtZ(i, j) = (*factorization.update_basis[j])[factorization.update_rows[i]];
+        }
+        factorization.capacitance.compute(MatrixXd::Identity(rank, rank) + D * PtZ);
+        factorization.update_stiffness = D;
+
+        for (int i = 0; i < factorization.cases.size(); i++) {
+            VectorXd solution = apply_update(&factorization, factorization.base_solutions[i]);
+            expand_solution(&factorization, factorization.cases[i], solution);
+        }
+    }
+    last_update_rank = affected_dofs.size();
+    last_solve_was_incremental = true;
+    return true;
+}
+
+/*
+Get the maximum number of affected dofs for which a low-rank update is applied instead of a refactorization. Unless set
+explicitly, it is a fraction of the free dofs. The cached columns of Z hold (free dofs) values per affected dof, so
+their memory grows with the square of the number of dofs for a fixed fraction; 2% keeps it at ~64 MB for a 100 x 100 grid.
+*/
+int fem::GridSolver2D::get_max_update_rank() {
+    if (max_update_rank > 0) return max_update_rank;
+    int no_free_dofs = factorizations.empty() ? no_dofs : factorizations[0].free_dofs.size();
+    return max(1, (int)(max_update_fraction * no_free_dofs));
+}
+
+// Correct a solution obtained with the factorized stiffness for the low-rank update currently applied to it
+VectorXd fem::GridSolver2D::apply_update(Factorization* factorization, VectorXd& base_solution) {
+    int rank = factorization->update_rows.size();
+    if (rank == 0) return base_solution;
+    VectorXd Ptu(rank);
+    for (int i = 0; i < rank; i++) Ptu[i] = base_solution[factorization->update_rows[i]];
+    VectorXd correction = factorization->capacitance.solve(factorization->update_stiffness * Ptu);
+    VectorXd solution = base_solution;
+    for (int i = 0; i < rank; i++) solution -= correction[i] * *factorization->update_basis[i];
+    return solution;
+}
+
+// Solve the reduced system of the given factorization for an arbitrary right-hand side, using the current stiffness
+VectorXd fem::GridSolver2D::solve_reduced(Factorization* factorization, VectorXd& rhs) {
+    VectorXd base_solution = factorization->ldlt->solve(rhs);
+    return apply_update(factorization, base_solution);
+}
+
+bool fem::GridSolver2D::solve(vector<double>* stiffness_factors, bool allow_low_rank_update) {
+    if (!allow_low_rank_update || base_factors.size() != stiffness_factors->size()) return factorize(stiffness_factors);
+    vector<int> changed_cells;
+    for (int cell = 0; cell < stiffness_factors->size(); cell++) {
+        if (stiffness_factors->at(cell) != base_factors[cell]) changed_cells.push_back(cell);
+    }
+    if (apply_low_rank_update(stiffness_factors, changed_cells)) return true;
+
+    return factorize(stiffness_factors);
+}
+
+bool fem::GridSolver2D::solve(grd::Densities2d* densities, bool allow_low_rank_update) {
+    vector<double> stiffness_factors;
+    get_stiffness_factors(densities, stiffness_factors, void_stiffness);
+    return solve(&stiffness_factors, allow_low_rank_update);
+}
+
+// Get the stress tensor components (xx, yy, xy) at the center of the given cell
+Matrix<double, 3, 1> fem::GridSolver2D::get_cell_stress(int load_case, int cell) {
+    int dofs[8];
+    get_element_dofs(cell, dofs);
+    Matrix<double, 8, 1> element_displacements;
+    for (int i = 0; i < 8; i++) element_displacements[i] = displacements[load_case][dofs[i]];
+    return constitutive * center_strain_displacement * element_displacements;
+}
+
+// Get the strain energy of the given cell, assuming it is filled
+double fem::GridSolver2D::get_cell_strain_energy(int load_case, int cell) {
+    int dofs[8];
+    get_element_dofs(cell, dofs);
+    Matrix<double, 8, 1> element_displacements;
+    for (int i = 0; i < 8; i++) element_displacements[i] = displacements[load_case][dofs[i]];
+    return 0.5 * element_displacements.dot(element_stiffness * element_displacements);
+}
+
+double fem::GridSolver2D::get_cell_vonmises(int load_case, int cell) {
+    Matrix<double, 3, 1> stress = get_cell_stress(load_case, cell);
+    double stress_zz = material.plane_stress ? 0 : material.poisson_ratio * (stress[0] + stress[1]);
+    return sqrt(0.5 * (
+        pow(stress[0] - stress[1], 2) + pow(stress[1] - stress_zz, 2) + pow(stress_zz - stress[0], 2)
+    ) + 3 * stress[2] * stress[2]);
+}
+
+// Get the gradient of the given cell's von Mises stress with respect to its element displacements
+void fem::GridSolver2D::get_stress_gradient(int load_case, int cell, Matrix<double, 8, 1>& gradient) {
+    Matrix<double, 3, 1> stress = get_cell_stress(load_case, cell);
+    double nu = material.plane_stress ? 0 : material.poisson_ratio;
+    double stress_zz = nu * (stress[0] + stress[1]);
+    double vonmises = get_cell_vonmises(load_case, cell);
+    if (vonmises == 0) {
+        gradient.setZero();
+        return;
+    }
+    Matrix<double, 3, 1> stress_gradient(
+        (stress[0] - stress[1]) - nu * (stress[1] - stress_zz) + (nu - 1) * (stress_zz - stress[0]),
+        -(stress[0] - stress[1]) + (1 - nu) * (stress[1] - stress_zz) + nu * (stress_zz - stress[0]),
+        6 * stress[2]
+    );
+    stress_gradient /= 2 * vonmises;
+    gradient = (constitutive * center_strain_displacement).transpose() * stress_gradient;
+}
+
+void fem::GridSolver2D::get_sensitivities(
+    grd::Densities2d* densities, string mechanical_constraint, vector<double>& sensitivities, double p
+) {
+    int no_cells = dim_x * dim_y;
+    sensitivities.assign(no_cells, 0.0);
+    int dofs[8];
+    bool stress_objective = mechanical_constraint != "Displacement";
+
+    // Compute the p-norm of the stresses. Stresses are scaled by their maximum to avoid overflow.
+    vector<int> aggregated_cells;
+    vector<vector<double>> cell_stresses(load_cases.size());
+    double pnorm = 0;
+    if (stress_objective) {
+        vector<bool> is_inactive(no_cells, false);
+        for (auto& cell : densities->fea_casemanager->inactive_cells) is_inactive[cell] = true;
+        for (int cell = 0; cell < no_cells; cell++) if (densities->at(cell) && !is_inactive[cell]) aggregated_cells.push_back(cell);
+        double max_stress = 0;
+        for (int load_case = 0; load_case < load_cases.size(); load_case++) {
+            cell_stresses[load_case].assign(no_cells, 0.0);
+            for (auto& cell : aggregated_cells) {
+                cell_stresses[load_case][cell] = get_cell_vonmises(load_case, cell);
+                max_stress = max(max_stress, cell_stresses[load_case][cell]);
+            }
+        }
+        if (max_stress == 0) return;
+        for (int load_case = 0; load_case < load_cases.size(); load_case++) {
+            for (auto& cell : aggregated_cells) pnorm += pow(cell_stresses[load_case][cell] / max_stress, p);
+        }
+        pnorm = max_stress * pow(pnorm, 1.0 / p);
+    }
+
+    for (auto& factorization : factorizations) {
+        for (auto& load_case : factorization.cases) {
+            // Obtain the adjoint solution. For compliance, the problem is self-adjoint.
+            VectorXd adjoint = displacements[load_case];
+            if (stress_objective) {
+                VectorXd rhs = VectorXd::Zero(factorization.free_dofs.size());
+                Matrix<double, 8, 1> gradient;
+                for (auto& cell : aggregated_cells) {
+                    get_stress_gradient(load_case, cell, gradient);
+                    double weight = pow(cell_stresses[load_case][cell] / pnorm, p - 1);
+                    get_element_dofs(cell, dofs);
+                    for (int i = 0; i < 8; i++) {
+                        int row = factorization.free_index[dofs[i]];
+                        if (row != -1) rhs[row] += weight * gradient[i];
+                    }
+                }
+                VectorXd reduced_adjoint = solve_reduced(&factorization, rhs);
+                adjoint.setZero();
+                for (int i = 0; i < factorization.free_dofs.size(); i++) adjoint[factorization.free_dofs[i]] = reduced_adjoint[i];
+            }
+            for (int cell = 0; cell < no_cells; cell++) {
+                get_element_dofs(cell, dofs);
+                Matrix<double, 8, 1> element_adjoint, element_displacements;
+                for (int i = 0; i < 8; i++) {
+                    element_adjoint[i] = adjoint[dofs[i]];
+                    element_displacements[i] = displacements[load_case][dofs[i]];
+                }
+                sensitivities[cell] += element_adjoint.dot(element_stiffness * element_displacements);
+            }
+        }
+    }
+}
+
+void fem::GridSolver2D::get_cellwise_results(string mechanical_constraint, vector<double>& cell_values) {
+    int no_cells = dim_x * dim_y;
+    cell_values.assign(no_cells, 0.0);
+    int dofs[8];
+    for (int load_case = 0; load_case < load_cases.size(); load_case++) {
+        for (int cell = 0; cell < no_cells; cell++) {
+            double value;
+            if (mechanical_constraint == "Displacement") {
+                // Mean displacement magnitude of the cell's corner nodes
+                get_element_dofs(cell, dofs);
+                value = 0;
+                for (int i = 0; i < 4; i++) {
+                    value += Vector2d(displacements[load_case][dofs[i * 2]], displacements[load_case][dofs[i * 2 + 1]]).norm();
+                }
+                value *= 0.25;
+            }
+            else {
+                Matrix<double, 3, 1> stress = get_cell_stress(load_case, cell);
+                if (mechanical_constraint == "Stress_xx") value = stress[0];
+                else if (mechanical_constraint == "Stress_yy") value = stress[1];
+                else if (mechanical_constraint == "Stress_xy") value = stress[2];
+                else value = get_cell_vonmises(load_case, cell);
+            }
+            cell_values[cell] = max(cell_values[cell], value);
+        }
+    }
+}
+
+// Write the results of the last solve to the given densities' FEA results, following the conventions of load_physics()
+void fem::GridSolver2D::write_results(grd::Densities2d* densities, string mechanical_constraint) {
+    vector<double> cell_values;
+    get_cellwise_results(mechanical_constraint, cell_values);
+    phys::FEAResults2D* results = &densities->fea_results;
+    phys::FEACaseManager* fea_casemanager = densities->fea_casemanager;
+    if (results->values.size() != densities->size) results->reset(densities->dim_x, densities->dim_y);
+    else results->clear();
+    results->min = INFINITY;
+    results->max = 0;
+    for (int cell = 0; cell < densities->size; cell++) {
+        if (!densities->at(cell)) continue;
+        if (help::is_in(&fea_casemanager->inactive_cells, cell)) {
+            // Cells marked as 'inactive' are ignored during solution evaluation.
+            results->set(cell, 0);
+            continue;
+        }
+        if (mechanical_constraint == "Displacement" && cell != fea_casemanager->displacement_measurement_cell) {
+            results->set(cell, 0);
+            continue;
+        }
+        double value = cell_values[cell];
+        results->set(cell, value);
+        if (value > results->max) results->max = value;
+        if (value < results->min) results->min = value;
+    }
+}
+
+fem::CoarseProxy2D::CoarseProxy2D(phys::FEACaseManager* fea_casemanager, grd::Densities2d* densities, int _factor) {
+    factor = _factor;
+    dim_x = (densities->dim_x + factor - 1) / factor;
+    dim_y = (densities->dim_y + factor - 1) / factor;
+    vector<LoadCase> fine_load_cases, load_cases;
+    create_load_cases(fea_casemanager, densities->dim_x, densities->dim_y, densities->cell_size, fine_load_cases);
+    for (auto& load_case : fine_load_cases) load_cases.push_back(coarsen(&load_case, densities->dim_y));
+    Material material = parse_material(&fea_casemanager->active_cases[0]);
+    solver = GridSolver2D(dim_x, dim_y, densities->cell_size * factor, material, load_cases);
+}
+
+// Map the given load case onto the coarse node grid. Each fine node is assigned to the nearest coarse node.
+fem::LoadCase fem::CoarseProxy2D::coarsen(LoadCase* load_case, int fine_dim_y) {
+    auto get_coarse_dof = [&](int dof) {
+        int node = dof / 2;
+        int x = min((node / (fine_dim_y + 1) + factor / 2) / factor, dim_x);
+        int y = min((node % (fine_dim_y + 1) + factor / 2) / factor, dim_y);
+        return (x * (dim_y + 1) + y) * 2 + dof % 2;
+    };
+    LoadCase coarse_load_case;
+    coarse_load_case.name = load_case->name;
+    for (auto& dof : load_case->fixed_dofs) coarse_load_case.fixed_dofs.push_back(get_coarse_dof(dof));
+    sort(coarse_load_case.fixed_dofs.begin(), coarse_load_case.fixed_dofs.end());
+    coarse_load_case.fixed_dofs.erase(
+        unique(coarse_load_case.fixed_dofs.begin(), coarse_load_case.fixed_dofs.end()), coarse_load_case.fixed_dofs.end()
+    );
+    for (auto& [dof, force] : load_case->nodal_forces) coarse_load_case.nodal_forces[get_coarse_dof(dof)] += force;
+    for (auto& dof : coarse_load_case.fixed_dofs) coarse_load_case.nodal_forces.erase(dof);
+    return coarse_load_case;
+}
+
+void fem::CoarseProxy2D::get_coarse_stiffness_factors(
+    grd::Densities2d* densities, vector<double>& factors, vector<double>& fill_fractions
+) {
+    fill_fractions.assign(dim_x * dim_y, 0.0);
+    for (int x = 0; x < densities->dim_x; x++) {
+        for (int y = 0; y < densities->dim_y; y++) {
+            if (densities->at(x * densities->dim_y + y)) fill_fractions[(x / factor) * dim_y + y / factor] += 1.0;
+        }
+    }
+    factors.resize(fill_fractions.size());
+    for (int i = 0; i < fill_fractions.size(); i++) {
+        fill_fractions[i] /= (double)(factor * factor);
+        factors[i] = max(fill_fractions[i], solver.void_stiffness);
+    }
+}
+
+double fem::CoarseProxy2D::estimate_max_stress(grd::Densities2d* densities, bool calibrated) {
+    vector<double> stiffness_factors, fill_fractions;
+    get_coarse_stiffness_factors(densities, stiffness_factors, fill_fractions);
+    if (!solver.solve(&stiffness_factors)) return INFINITY;
+    phys::FEACaseManager* fea_casemanager = densities->fea_casemanager;
+    vector<double> cell_values;
+    solver.get_cellwise_results(fea_casemanager->mechanical_constraint, cell_values);
+
+    double max_stress = 0;
+    if (fea_casemanager->mechanical_constraint == "Displacement") {
+        int cell = fea_casemanager->displacement_measurement_cell;
+        max_stress = cell_values[(cell / densities->dim_y / factor) * dim_y + (cell % densities->dim_y) / factor];
+    }
+    else {
+        // Mostly empty coarse cells are ignored, since their strains are dominated by the discretization error
+        vector<bool> is_inactive(dim_x * dim_y, false);
+        for (auto& cell : fea_casemanager->inactive_cells) {
+            is_inactive[(cell / densities->dim_y / factor) * dim_y + (cell % densities->dim_y) / factor] = true;
+        }
+        for (int i = 0; i < cell_values.size(); i++) {
+            if (fill_fractions[i] < 0.5 || is_inactive[i]) continue;
+            max_stress = max(max_stress, cell_values[i]);
+        }
+    }
+    if (calibrated) max_stress *= calibration;
+    return max_stress;
+}
+
+// Add a sample to the calibration of the proxy, given an uncalibrated estimate and the corresponding full FEA result
+void fem::CoarseProxy2D::calibrate(double estimate, double full_max_stress) {
+    if (estimate <= 0 || !isfinite(estimate) || !isfinite(full_max_stress)) return;
+    calibration_samples.push_back(full_max_stress / estimate);
+    if (calibration_samples.size() > max_calibration_samples) calibration_samples.pop_front();
+    vector<double> ratios(calibration_samples.begin(), calibration_samples.end());
+    nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2, ratios.end());
+    calibration = ratios[ratios.size() / 2];
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <Eigen/Core>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include "densities.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+namespace fessga {
+
+    /*
+    In-process linear elastic solver for 2d density distributions.
+    The design domain is discretized with one bilinear quad element per grid cell. Node numbering follows the
+    convention used by msh::create_FE_mesh, i.e. node = x * (dim_y + 1) + y, with two degrees of freedom per node.
+    Empty cells are given an ersatz stiffness so that the stiffness matrix keeps the same sparsity pattern for all
+    density distributions, which allows the factorization to be reused across iterations.
+    */
+    class fem {
+    public:
+
+        struct Material {
+            double youngs_modulus = 1.0;
+            double poisson_ratio = 0.3;
+            bool plane_stress = false; // Elmer solves 2d elasticity problems in plane strain unless told otherwise
+        };
+
+        // Boundary conditions of a single FEA case, expressed in terms of degrees of freedom on the node grid
+        class LoadCase {
+        public:
+            LoadCase() = default;
+            LoadCase(phys::FEACase* fea_case, int dim_x, int dim_y, Vector2d cell_size);
+            string name;
+            vector<int> fixed_dofs;
+            map<int, double> nodal_forces;
+        };
+
+        class GridSolver2D {
+        public:
+            GridSolver2D() = default;
+            GridSolver2D(
+                int _dim_x, int _dim_y, Vector2d _cell_size, Material _material, vector<LoadCase> _load_cases,
+                double _void_stiffness = 1e-9
+            );
+
+            // Solve all load cases for the given distribution. If <allow_low_rank_update> is set, the factorization
+            // of the previous full solve is reused and the change in stiffness is applied as a low-rank update, as long
+            // as the number of affected degrees of freedom does not exceed the maximum update rank (see get_max_update_rank).
+            bool solve(grd::Densities2d* densities, bool allow_low_rank_update = false);
+            bool solve(vector<double>* stiffness_factors, bool allow_low_rank_update = false);
+
+            // Compute the cellwise value of the given mechanical constraint ("Vonmises", "Stress_xx", "Stress_yy",
+            // "Stress_xy" or "Displacement"), maximized over all load cases.
+            void get_cellwise_results(string mechanical_constraint, vector<double>& cell_values);
+            void write_results(grd::Densities2d* densities, string mechanical_constraint);
+            Matrix<double, 3, 1> get_cell_stress(int load_case, int cell);
+            double get_cell_strain_energy(int load_case, int cell);
+            double get_cell_vonmises(int load_case, int cell);
+            int get_max_update_rank();
+
+            // Compute the cellwise sensitivity of the objective that corresponds to the given mechanical constraint, expressed
+            // as the decrease of the objective per unit of added stiffness. For stress constraints the objective is the p-norm
+            // of the von Mises stresses in all active filled cells over all load cases; otherwise it is the total compliance.
+            // Requires one additional back-substitution per load case.
+            void get_sensitivities(
+                grd::Densities2d* densities, string mechanical_constraint, vector<double>& sensitivities, double p = 8.0
+            );
+
+            int dim_x = 0, dim_y = 0;
+            int no_nodes = 0, no_dofs = 0;
+            Vector2d cell_size;
+            Material material;
+            vector<LoadCase> load_cases;
+            double void_stiffness = 1e-9;
+            int max_update_rank = 0; // Maximum number of dofs affected by a low-rank update. If 0, <max_update_fraction> is used.
+            double max_update_fraction = 0.02; // Maximum update rank as a fraction of the number of free dofs
+            int last_update_rank = 0;
+            bool last_solve_was_incremental = false;
+            vector<VectorXd> displacements; // Full displacement vector per load case
+
+        protected:
+            // Load cases with identical sets of fixed degrees of freedom share a single factorization
+            struct Factorization {
+                vector<int> free_index; // Maps each dof to its row in the reduced system, or -1 if the dof is fixed
+                vector<int> free_dofs;
+                vector<int> cases;
+                vector<VectorXd> base_solutions; // Reduced solution of each case for the factorized stiffness
+                map<int, VectorXd> update_columns; // Cached columns of K^-1 P, keyed by dof
+                shared_ptr<SimplicialLDLT<SparseMatrix<double>>> ldlt;
+
+                // Low-rank update currently applied on top of the factorization (empty if none)
+                vector<int> update_rows; // Rows of the affected dofs in the reduced system
+                vector<const VectorXd*> update_basis; // Columns of Z = K^-1 P, which point into <update_columns>
+                MatrixXd update_stiffness; // D
+                PartialPivLU<MatrixXd> capacitance; // I + D P^T Z
+            };
+
+            void compute_element_stiffness();
+            void get_element_dofs(int cell, int* dofs);
+            bool factorize(vector<double>* stiffness_factors);
+            bool apply_low_rank_update(vector<double>* stiffness_factors, vector<int>& changed_cells);
+            void expand_solution(Factorization* factorization, int load_case, VectorXd& reduced_solution);
+            VectorXd apply_update(Factorization* factorization, VectorXd& base_solution);
+            VectorXd solve_reduced(Factorization* factorization, VectorXd& rhs);
+            void get_stress_gradient(int load_case, int cell, Matrix<double, 8, 1>& gradient);
+
+            Matrix<double, 8, 8> element_stiffness;
+            Matrix<double, 3, 8> center_strain_displacement;
+            Matrix3d constitutive;
+            vector<Factorization> factorizations;
+            vector<double> base_factors;
+        };
+
+        /*
+        Cheap estimate of the maximum stress of a density distribution, obtained by solving on a grid that is coarser by
+        the given factor. Each coarse cell is given a stiffness proportional to the fraction of filled cells it covers.
+        The estimate is scaled by the median ratio between full FEA results and uncalibrated estimates seen so far.
+        */
+        class CoarseProxy2D {
+        public:
+            CoarseProxy2D() = default;
+            CoarseProxy2D(phys::FEACaseManager* fea_casemanager, grd::Densities2d* densities, int _factor = 2);
+            double estimate_max_stress(grd::Densities2d* densities, bool calibrated = true);
+            void calibrate(double estimate, double full_max_stress);
+
+            int factor = 2;
+            int dim_x = 0, dim_y = 0;
+            double calibration = 1.0;
+            int max_calibration_samples = 100;
+            GridSolver2D solver;
+        protected:
+            void get_coarse_stiffness_factors(grd::Densities2d* densities, vector<double>& factors, vector<double>& fill_fractions);
+            LoadCase coarsen(LoadCase* load_case, int fine_dim_y);
+            list<double> calibration_samples;
+        };
+
+        static Material parse_material(phys::FEACase* fea_case);
+        static void parse_boundary_values(phys::FEACase* fea_case, map<string, map<string, double>>& boundary_values);
+        static void get_stiffness_factors(grd::Densities2d* densities, vector<double>& factors, double void_stiffness);
+        static void create_load_cases(
+            phys::FEACaseManager* fea_casemanager, int dim_x, int dim_y, Vector2d cell_size, vector<LoadCase>& load_cases
+        );
+    };
+}
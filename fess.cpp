@@ -12,7 +12,10 @@ void FESS::export_meta_parameters(vector<string>*_) {
 	vector<string> additional_metaparameters = {
 		feasibility_filtering,
 		"initial greediness = " + to_string(greediness),
-		bound_connection
+		bound_connection,
+		"incremental reanalysis = " + string(incremental_reanalysis ? "yes" : "no"),
+		"FEA solver = " + string(incremental_reanalysis ? "in-process Q4 model (GridSolver2D)" : "Elmer"),
+		"max update fraction = " + to_string(max_update_fraction)
 	};
 	OptimizerBase::export_meta_parameters(&additional_metaparameters);
 }
@@ -20,13 +23,14 @@ void FESS::export_meta_parameters(vector<string>*_) {
 void FESS::export_stats(string iteration_name) {
 	cout << "Exporting statistics to " << statistics_file << endl;
 	if (initialize) IO::write_text_to_file(
-		"Iteration, Iteration time, Relative area, Greediness, #Cells removed, Available RAM",
+		"Iteration, Iteration time, Relative area, Greediness, #Cells removed, Update rank, Available RAM",
 		statistics_file
 	);
 	stats.push_back(to_string(iteration_number));
 	stats.push_back(to_string(relative_area));
 	stats.push_back(to_string(greediness));
 	stats.push_back(to_string(no_cells_removed));
+	stats.push_back(to_string(solver.last_solve_was_incremental ? solver.last_update_rank : -1));
 	export_base_stats();
 	initialize = false;
 }
@@ -119,9 +123,35 @@ void FESS::fill_design_domain() {
 }
 
 
+// Run FEA using the in-process solver rather than Elmer. Element removal only changes the stiffness of a small number of cells
+// per iteration, so the solver applies these changes as a low-rank update to the factorization of a previous iteration
+// rather than re-assembling and re-factorizing the stiffness matrix. Once the accumulated changes exceed the
+// maximum update rank, the solver re-factorizes.
+bool FESS::run_in_process_fea() {
+	if (solver.no_dofs == 0) {
+		vector<fem::LoadCase> load_cases;
+		fem::create_load_cases(&fea_casemanager, densities.dim_x, densities.dim_y, densities.cell_size, load_cases);
+		fem::Material material = fem::parse_material(&fea_casemanager.active_cases[0]);
+		solver = fem::GridSolver2D(densities.dim_x, densities.dim_y, densities.cell_size, material, load_cases);
+		solver.max_update_fraction = max_update_fraction;
+	}
+	cout << "FESS: Running in-process FEA...\n";
+	if (!solver.solve(&densities, true)) {
+		cout << "FESS: ERROR: In-process FEA failed.\n";
+		return false;
+	}
+	if (solver.last_solve_was_incremental) cout << "FESS: Applied update of rank " << solver.last_update_rank
+		<< " to previous factorization.\n";
+	else cout << "FESS: Re-factorized stiffness matrix.\n";
+	solver.write_results(&densities, fea_casemanager.mechanical_constraint);
+	return true;
+}
+
 void FESS::run() {
 	cout << "Beginning FESS run. Saving results to " << output_folder << endl;
 	export_meta_parameters();
+	if (incremental_reanalysis) cout << "FESS: Using the in-process Q4 solver instead of Elmer. Stresses (and thus the stress "
+		<< "thresholds) are not directly comparable to those of runs with Elmer.\n";
 	double min_stress, max_stress;
 	string final_valid_iteration_folder;
 	int final_valid_iteration = 1;
@@ -144,32 +174,39 @@ void FESS::run() {
 		}
 		densities.output_folder = iteration_folder;
 
-		// Generate new FE mesh using modified density distribution
-		cout << "FESS: Generating new FE mesh...\n";
 		msh::FEMesh2D fe_mesh;
-		msh::create_FE_mesh(mesh, densities, fe_mesh);
-		cout << "FESS: FE mesh generation done.\n";
-
-		create_sif_files(&densities, &fe_mesh);
-
-		// Export newly generated FE mesh
-		msh::export_as_elmer_files(&fe_mesh, iteration_folder);
-		if (export_msh) msh::export_as_msh_file(&fe_mesh, iteration_folder);
-		if (IO::file_exists(iteration_folder + "/mesh.header")) cout << "FESS: Exported new FE mesh.\n";
-		else cout << "FESS: ERROR: Failed to export new FE mesh.\n";
-
-		// Export density distribution
-		string densities_file = densities.do_export(iteration_folder + "/distribution2d.dens");
-		cout << "FESS: Exported current density distribution.\n";
-
-		// Call Elmer to run FEA on new FE mesh
-		string batch_file = msh::create_batch_file(iteration_folder);
-		cout << "FESS: Calling Elmer .bat file...\n";
-		fessga::phys::call_elmer(iteration_folder, &fea_casemanager);
-		cout << "FESS: ElmerSolver finished. Attempting to read .vtk file...\n";
-
-		// Obtain vonmises stress distribution from the .vtk files
-		load_physics(&densities, &mesh, verbose);
+		if (incremental_reanalysis) {
+			string densities_file = densities.do_export(iteration_folder + "/distribution2d.dens");
+			cout << "FESS: Exported current density distribution.\n";
+			if (!run_in_process_fea()) break;
+		}
+		else {
+			// Generate new FE mesh using modified density distribution
+			cout << "FESS: Generating new FE mesh...\n";
+			msh::create_FE_mesh(mesh, densities, fe_mesh);
+			cout << "FESS: FE mesh generation done.\n";
+
+			create_sif_files(&densities, &fe_mesh);
+
+			// Export newly generated FE mesh
+			msh::export_as_elmer_files(&fe_mesh, iteration_folder);
+			if (export_msh) msh::export_as_msh_file(&fe_mesh, iteration_folder);
+			if (IO::file_exists(iteration_folder + "/mesh.header")) cout << "FESS: Exported new FE mesh.\n";
+			else cout << "FESS: ERROR: Failed to export new FE mesh.\n";
+
+			// Export density distribution
+			string densities_file = densities.do_export(iteration_folder + "/distribution2d.dens");
+			cout << "FESS: Exported current density distribution.\n";
+
+			// Call Elmer to run FEA on new FE mesh
+			string batch_file = msh::create_batch_file(iteration_folder);
+			cout << "FESS: Calling Elmer .bat file...\n";
+			fessga::phys::call_elmer(iteration_folder, &fea_casemanager);
+			cout << "FESS: ElmerSolver finished. Attempting to read .vtk file...\n";
+
+			// Obtain vonmises stress distribution from the .vtk files
+			load_physics(&densities, &mesh, verbose, false, &fe_mesh.node_grid_indices);
+		}
 
 		// Get minimum and maximum stress values
 		max_stress = densities.fea_results.max;
@@ -8,6 +8,7 @@
 #include <functional>
 #include "helpers.h"
 #include "optimizerBase.h"
+#include "fem.h"
 
 
 class FESS : public OptimizerBase {
@@ -16,18 +17,27 @@ public:
 	FESS(
 		phys::FEACaseManager fea_casemanager, msh::SurfaceMesh mesh, string base_folder, double _min_stress_threshold,
 		grd::Densities2d _densities, int max_iterations, float _greediness, bool _do_feasibility_filtering,
-		bool export_msh = false, bool verbose = true
+		bool export_msh = false, bool verbose = true, bool _incremental_reanalysis = false,
+		float _max_update_fraction = 0.02
 	) : OptimizerBase(fea_casemanager, mesh, base_folder, _densities, max_iterations, export_msh, verbose)
 	{
 		min_stress_threshold = _min_stress_threshold;
 		greediness = _greediness;
 		do_feasibility_filtering = _do_feasibility_filtering;
+		incremental_reanalysis = _incremental_reanalysis;
+		max_update_fraction = _max_update_fraction;
 	}
 	double min_stress_threshold = 1.0;
 	float greediness;
 	double relative_area = INFINITY;
 	bool do_feasibility_filtering = false;
 	int no_cells_removed = 0;
+	// Solve with the in-process Q4 model (fem::GridSolver2D) instead of Elmer, reusing the factorization of previous
+	// iterations. Stresses differ from Elmer's, so the stress thresholds may need to be recalibrated.
+	bool incremental_reanalysis = false;
+	float max_update_fraction = 0.02; // Maximum rank of a low-rank update as a fraction of the free dofs
+
+	fem::GridSolver2D solver;
 
 	void run();
 	void log_termination(string final_valid_iteration_folder, int final_valid_iteration);
@@ -35,6 +45,7 @@ public:
 		msh::FEMesh2D* fe_mesh, int no_cells_to_remove, int no_cells_removed, bool recurse = true
 	);
 	void fill_design_domain();
+	bool run_in_process_fea();
 	void export_stats(string iteration_name);
 	void export_meta_parameters(vector<string>* _ = 0);
 };
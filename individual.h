@@ -28,6 +28,9 @@ namespace fessga {
 				fea_casemanager = individual->fea_casemanager;
 				fe_mesh = individual->fe_mesh;
 				fitness = individual->fitness;
+				fitness_is_proxy = individual->fitness_is_proxy;
+				proxy_max_stress = individual->proxy_max_stress;
+				fitness_is_cached = individual->fitness_is_cached;
 				output_folder = individual->output_folder;
 				copy_from_individual(individual);
 			}
@@ -40,6 +43,9 @@ namespace fessga {
 			void copy_from_individual(Individual2d* source);
 			void fill_smaller_fenestrae(int target_no_cells, bool verbose = false);
 			double fitness = 0;
+			bool fitness_is_proxy = false; // Set if the individual's FEA results are estimates obtained during pre-screening
+			double proxy_max_stress = -1; // Uncalibrated maximum stress estimate obtained during pre-screening
+			bool fitness_is_cached = false; // Set if the individual's FEA results were taken from the FEA results cache
 			msh::FEMesh2D fe_mesh;
 			int iteration = 0;
 		protected:
@@ -258,3 +258,25 @@ bool fessga::IO::file_is_empty(string fpath) {
 
     return is_empty;
 }
+
+fessga::IO::MappedFile::MappedFile(string fpath) {
+    file_handle = CreateFileA(
+        fpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL
+    );
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        return;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) return; // Empty files cannot be mapped
+    mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_handle == NULL) return;
+    data = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data != nullptr) size = (size_t)file_size.QuadPart;
+}
+
+fessga::IO::MappedFile::~MappedFile() {
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    if (file_handle != nullptr) CloseHandle(file_handle);
+}
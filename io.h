@@ -46,5 +46,20 @@ namespace fessga {
 		static void remove_directory_incl_contents(std::string dir);
 
 		static bool file_is_empty(std::string fpath);
+
+		// Read-only memory mapping of a file. The mapping is released when the object goes out of scope.
+		// If the file does not exist or is empty, <data> is a null pointer.
+		class MappedFile {
+		public:
+			MappedFile(std::string fpath);
+			~MappedFile();
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			const char* data = nullptr;
+			size_t size = 0;
+		private:
+			void* file_handle = nullptr;
+			void* mapping_handle = nullptr;
+		};
 	};
 };
@@ -0,0 +1,175 @@
+#pragma once
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "islands.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+
+// Message header of a batch of migrants, followed by the number of migrants
+static const char MIGRANTS_MAGIC[4] = { 'M', 'I', 'G', 'R' };
+
+// Upper bound on the number of migrants in a received batch, to reject corrupt or foreign messages
+static const uint32_t MAX_MIGRANTS = 1 << 16;
+
+// Wait until the given socket is readable (or writable), or until <timeout> seconds have passed
+static bool wait_until_ready(SOCKET socket, double timeout, bool writable = false) {
+	fd_set ready;
+	FD_ZERO(&ready);
+	FD_SET(socket, &ready);
+	timeval tv = { (long)timeout, (long)((timeout - (long)timeout) * 1e6) };
+	return select((int)socket + 1, writable ? 0 : &ready, writable ? &ready : 0, 0, &tv) > 0;
+}
+
+/*
+Connect to the neighbouring islands. Since the islands are started independently, the connection to the successor is
+retried until it starts listening or <timeout> seconds have passed.
+*/
+bool IslandChannel::open(int _island, int _no_islands, int _base_port, vector<string> _hosts, double timeout) {
+	island = _island; no_islands = _no_islands; base_port = _base_port; hosts = _hosts;
+	int successor_island = (island + 1) % no_islands;
+	string successor_host = successor_island < hosts.size() ? hosts[successor_island] : "127.0.0.1";
+	WSADATA wsa_data;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return false;
+	winsock_started = true;
+
+	// Listen for the predecessor
+	SOCKET _listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	int reuse = 1;
+	setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(base_port + island);
+	if (bind(_listener, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR || listen(_listener, 1) == SOCKET_ERROR) {
+		cout << "IslandChannel: ERROR: Island " << island << " is unable to listen on port " << base_port + island << endl;
+		closesocket(_listener);
+		return false;
+	}
+	listener = (uintptr_t)_listener;
+
+	// Connect to the successor
+	sockaddr_in successor_address = {};
+	successor_address.sin_family = AF_INET;
+	successor_address.sin_port = htons(base_port + successor_island);
+	inet_pton(AF_INET, successor_host.c_str(), &successor_address.sin_addr);
+	auto deadline = chrono::steady_clock::now() + chrono::duration<double>(timeout);
+	while (successor == no_socket && chrono::steady_clock::now() < deadline) {
+		SOCKET _successor = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (connect(_successor, (sockaddr*)&successor_address, sizeof(successor_address)) == 0) {
+			int no_delay = 1;
+			setsockopt(_successor, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+			successor = (uintptr_t)_successor;
+		}
+		else {
+			closesocket(_successor);
+			this_thread::sleep_for(chrono::milliseconds(100));
+		}
+	}
+	if (successor == no_socket) {
+		cout << "IslandChannel: ERROR: Island " << island << " is unable to connect to island " << successor_island
+			<< " at " << successor_host << ":" << base_port + successor_island << endl;
+		close();
+		return false;
+	}
+
+	// Accept the predecessor's connection
+	double remaining = chrono::duration<double>(deadline - chrono::steady_clock::now()).count();
+	if (!wait_until_ready(_listener, max(0.0, remaining))) {
+		cout << "IslandChannel: ERROR: Island " << island << " was not contacted by its predecessor.\n";
+		close();
+		return false;
+	}
+	SOCKET _predecessor = accept(_listener, 0, 0);
+	if (_predecessor == INVALID_SOCKET) {
+		close();
+		return false;
+	}
+	predecessor = (uintptr_t)_predecessor;
+	return true;
+}
+
+void IslandChannel::close() {
+	for (uintptr_t* _socket : { &predecessor, &successor, &listener }) {
+		if (*_socket == no_socket) continue;
+		closesocket((SOCKET)*_socket);
+		*_socket = no_socket;
+	}
+	if (winsock_started) WSACleanup();
+	winsock_started = false;
+}
+
+bool IslandChannel::send_all(const char* data, size_t size, double timeout) {
+	auto deadline = chrono::steady_clock::now() + chrono::duration<double>(timeout);
+	while (size > 0) {
+		double remaining = chrono::duration<double>(deadline - chrono::steady_clock::now()).count();
+		if (remaining <= 0 || !wait_until_ready((SOCKET)successor, remaining, true)) return false;
+		int no_sent = ::send((SOCKET)successor, data, (int)min(size, (size_t)(1 << 20)), 0);
+		if (no_sent <= 0) return false;
+		data += no_sent;
+		size -= no_sent;
+	}
+	return true;
+}
+
+bool IslandChannel::receive_all(char* data, size_t size, double timeout) {
+	auto deadline = chrono::steady_clock::now() + chrono::duration<double>(timeout);
+	while (size > 0) {
+		double remaining = chrono::duration<double>(deadline - chrono::steady_clock::now()).count();
+		if (remaining <= 0 || !wait_until_ready((SOCKET)predecessor, remaining)) return false;
+		int no_received = recv((SOCKET)predecessor, data, (int)min(size, (size_t)(1 << 20)), 0);
+		if (no_received <= 0) return false;
+		data += no_received;
+		size -= no_received;
+	}
+	return true;
+}
+
+/*
+Send the given migrants to the successor island. Return false if they could not be sent within <timeout> seconds. Since
+every island sends before its successor receives, large batches only get through if the islands receive while they send
+(see Evolver::migrate).
+*/
+bool IslandChannel::send(vector<Migrant>* migrants, double timeout) {
+	if (!is_open()) return false;
+	string message(MIGRANTS_MAGIC, 4);
+	auto put = [&message](const void* value, size_t size) { message.append((const char*)value, size); };
+	uint32_t no_migrants = migrants->size();
+	put(&no_migrants, sizeof(no_migrants));
+	for (auto& migrant : *migrants) {
+		int32_t dims[2] = { migrant.dim_x, migrant.dim_y };
+		uint32_t no_words = migrant.bits.size();
+		put(dims, sizeof(dims));
+		put(&migrant.fitness, sizeof(migrant.fitness));
+		put(&no_words, sizeof(no_words));
+		put(migrant.bits.data(), no_words * sizeof(uint64_t));
+	}
+	return send_all(message.data(), message.size(), timeout);
+}
+
+// Receive a batch of migrants from the predecessor island. Return false if none arrived within <timeout> seconds.
+bool IslandChannel::receive(vector<Migrant>& migrants, double timeout) {
+	if (!is_open()) return false;
+	char magic[4];
+	uint32_t no_migrants = 0;
+	if (!receive_all(magic, 4, timeout) || memcmp(magic, MIGRANTS_MAGIC, 4) != 0) return false;
+	if (!receive_all((char*)&no_migrants, sizeof(no_migrants), timeout) || no_migrants > MAX_MIGRANTS) return false;
+	migrants.clear();
+	for (int i = 0; i < no_migrants; i++) {
+		Migrant migrant;
+		int32_t dims[2];
+		uint32_t no_words = 0;
+		if (!receive_all((char*)dims, sizeof(dims), timeout)) return false;
+		if (!receive_all((char*)&migrant.fitness, sizeof(migrant.fitness), timeout)) return false;
+		if (!receive_all((char*)&no_words, sizeof(no_words), timeout)) return false;
+		if (dims[0] <= 0 || dims[1] <= 0 || no_words != ((int64_t)dims[0] * dims[1] + 63) / 64) return false;
+		migrant.dim_x = dims[0];
+		migrant.dim_y = dims[1];
+		migrant.bits.resize(no_words);
+		if (!receive_all((char*)migrant.bits.data(), no_words * sizeof(uint64_t), timeout)) return false;
+		migrants.push_back(migrant);
+	}
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+typedef unsigned int uint;
+
+
+/*
+Individual that migrates between islands. Only its density distribution and fitness are sent; the receiving island
+re-evaluates it.
+*/
+struct Migrant {
+	int dim_x = 0, dim_y = 0;
+	double fitness = 0;
+	vector<uint64_t> bits; // Density values, 64 cells per word
+
+	void set_densities(uint* values, int size) {
+		bits.assign((size + 63) / 64, 0);
+		for (int cell = 0; cell < size; cell++) bits[cell >> 6] |= (uint64_t)(values[cell] & 1) << (cell & 63);
+	}
+	bool get_density(int cell) const { return (bits[cell >> 6] >> (cell & 63)) & 1; }
+};
+
+/*
+TCP connections of an island to its neighbours in a ring of <no_islands> islands. Island i listens on port
+<base_port> + i for its predecessor, and connects to its successor, island (i + 1) % no_islands, on the successor's host.
+Islands may run as processes on the same machine (all hosts "127.0.0.1") or on several nodes. Migrants are sent to the
+successor and received from the predecessor.
+*/
+class IslandChannel {
+public:
+	IslandChannel() = default;
+	~IslandChannel() { close(); }
+	IslandChannel(const IslandChannel&) = delete;
+	IslandChannel& operator=(const IslandChannel&) = delete;
+	bool open(int _island, int _no_islands, int _base_port = 50000, vector<string> _hosts = {}, double timeout = 300);
+	bool send(vector<Migrant>* migrants, double timeout = 300);
+	bool receive(vector<Migrant>& migrants, double timeout = 300);
+	void close();
+	bool is_open() const { return successor != no_socket && predecessor != no_socket; }
+	int island = 0;
+	int no_islands = 1;
+	int base_port = 50000;
+	vector<string> hosts; // Host of each island. If empty, all islands are assumed to run on localhost.
+private:
+	static const uintptr_t no_socket = ~(uintptr_t)0;
+	bool send_all(const char* data, size_t size, double timeout);
+	bool receive_all(char* data, size_t size, double timeout);
+	uintptr_t listener = no_socket, successor = no_socket, predecessor = no_socket;
+	bool winsock_started = false;
+};
@@ -13,6 +13,15 @@ void parse_args(
     int argc, char* argv[], Input& input, string& base_folder, string& action,
     int& dim_x
     ) {
+    // Named options (--seed=<n>) may be given anywhere. They are taken out before the positional arguments are parsed.
+    vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--seed=", 0) == 0) input.seed = stoull(arg.substr(7));
+        else args.push_back(argv[i]);
+    }
+    argc = args.size();
+    argv = args.data();
     action = argv[1];
     base_folder = "E:/Development/FESSGA/data/" + string(argv[2]);
     string relative_path = string(argv[3]);
@@ -41,7 +50,19 @@ void parse_args(
     input.max_stress = atof(argv[7]);
     input.max_iterations = atoi(argv[8]);
     input.mechanical_constraint = argv[9];
-    if (help::is_in(action, "evolve")) input.stress_fitness_influence = atof(argv[10]);
+    if (help::is_in(action, "evolve")) {
+        input.stress_fitness_influence = atof(argv[10]);
+        if (argc > 11) input.no_threads = atoi(argv[11]);
+        if (argc > 13) {
+            input.island = atoi(argv[12]);
+            input.no_islands = atoi(argv[13]);
+        }
+        if (argc > 14 && string(argv[14]) != "localhost") help::split(string(argv[14]), ",", input.island_hosts);
+    }
+    if (action == "extract_archive") {
+        input.archive_path = base_folder + "/" + string(argv[10]);
+        if (argc > 11) input.archive_record = argv[11];
+    }
 }
 
 
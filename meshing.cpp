@@ -348,4 +348,8 @@ void msh::create_FE_mesh(
     fe_mesh.lines = lines;
     fe_mesh.surfaces = surfaces;
     fe_mesh.nodes = nodes;
+
+    // Node ids equal the node grid index + 1, so the grid index of each exported node can be looked up directly when reading results
+    fe_mesh.node_grid_indices.resize(nodes.size());
+    for (int i = 0; i < nodes.size(); i++) fe_mesh.node_grid_indices[i] = (int)nodes[i][0] - 1;
 }
\ No newline at end of file
@@ -71,6 +71,7 @@ namespace fessga {
         // Define the struct for a 2D Finite Element mesh
         struct FEMesh2D {
             vector<vector<double>> nodes;
+            vector<int> node_grid_indices; // Node grid index of each node, in the order in which the nodes are exported
             vector<Element> lines;
             vector<Element> surfaces;
         };
@@ -271,11 +272,41 @@ namespace fessga {
             export_elmer_boundary(fe_mesh, base_folder);
         }
 
-        // Create batch file for running elmer and return its absolute path
+        // Write the given nodal values on the surfaces of the FE mesh as a legacy ASCII .vtk file, in the layout of Elmer's
+        // results files. Values are indexed by node of the FE mesh, or by node grid index if there are more values than nodes
+        // (as in results archives written before case fields were stored per mesh node).
+        static void export_nodal_field_as_vtk(FEMesh2D* fe_mesh, string name, vector<float>* values, string outfile) {
+            int max_node = 0;
+            for (auto& node_idx : fe_mesh->node_grid_indices) max_node = max(max_node, node_idx);
+            vector<int> point_indices(max_node + 1, -1);
+            for (int i = 0; i < fe_mesh->node_grid_indices.size(); i++) point_indices[fe_mesh->node_grid_indices[i]] = i;
+
+            string vtk = "# vtk DataFile Version 3.0\n" + name + "\nASCII\nDATASET UNSTRUCTURED_GRID\n";
+            vtk += "POINTS " + to_string(fe_mesh->nodes.size()) + " double\n";
+            for (auto& node : fe_mesh->nodes) vtk += to_string(node[1]) + " " + to_string(node[2]) + " " + to_string(node[3]) + "\n";
+            vtk += "CELLS " + to_string(fe_mesh->surfaces.size()) + " " + to_string(fe_mesh->surfaces.size() * 5) + "\n";
+            for (auto& surface : fe_mesh->surfaces) {
+                vtk += "4";
+                for (auto& node_id : surface.nodes) vtk += " " + to_string(point_indices[node_id - 1]);
+                vtk += "\n";
+            }
+            vtk += "CELL_TYPES " + to_string(fe_mesh->surfaces.size()) + "\n";
+            for (int i = 0; i < fe_mesh->surfaces.size(); i++) vtk += "9\n";
+            vtk += "POINT_DATA " + to_string(fe_mesh->nodes.size()) + "\nSCALARS " + name + " double\nLOOKUP_TABLE default\n";
+            bool is_grid_indexed = values->size() > fe_mesh->node_grid_indices.size();
+            for (int i = 0; i < fe_mesh->node_grid_indices.size(); i++) {
+                int idx = is_grid_indexed ? fe_mesh->node_grid_indices[i] : i;
+                vtk += to_string(idx < values->size() ? values->at(idx) : 0.0f) + "\n";
+            }
+            IO::write_text_to_file(vtk, outfile);
+        }
+
+        // Create batch file for running elmer and return its absolute path. The batch file's first argument, if given, is
+        // passed on to ElmerSolver as the case file to solve; otherwise ElmerSolver reads it from ELMERSOLVER_STARTINFO.
         static string create_batch_file(string base_folder) {
             string batch_file = IO::get_fullpath(base_folder);
             batch_file += "/run_elmer.bat";
-            IO::write_text_to_file("cd \"" + base_folder + "\"\nElmerSolver", batch_file);
+            IO::write_text_to_file("cd \"" + base_folder + "\"\nElmerSolver %1", batch_file);
 
             return batch_file;
         }
@@ -416,6 +447,131 @@ namespace fessga {
             //cout << "no boundary lines: " << q << endl;
         }
 
+        // Map the given boundary lines from a node grid of (source_dim_x + 1) x (source_dim_y + 1) nodes onto a node grid of
+        // (target_dim_x + 1) x (target_dim_y + 1) nodes covering the same domain. Mapped lines are subdivided into lines of unit length.
+        static void resample_boundary_lines(
+            vector<pair<int, int>>* lines, int source_dim_x, int source_dim_y, int target_dim_x, int target_dim_y,
+            vector<pair<int, int>>& resampled_lines
+        ) {
+            auto get_target_node_coords = [&](int node) {
+                int x = round((double)(node / (source_dim_y + 1)) * (double)target_dim_x / (double)source_dim_x);
+                int y = round((double)(node % (source_dim_y + 1)) * (double)target_dim_y / (double)source_dim_y);
+                return pair(x, y);
+            };
+            for (auto& line : *lines) {
+                auto [x1, y1] = get_target_node_coords(line.first);
+                auto [x2, y2] = get_target_node_coords(line.second);
+                int no_steps = max(abs(x2 - x1), abs(y2 - y1));
+                int step_x = (x2 > x1) - (x2 < x1);
+                int step_y = (y2 > y1) - (y2 < y1);
+                for (int i = 0; i < no_steps; i++) {
+                    int node1 = (x1 + i * step_x) * (target_dim_y + 1) + y1 + i * step_y;
+                    int node2 = (x1 + (i + 1) * step_x) * (target_dim_y + 1) + y1 + (i + 1) * step_y;
+                    pair<int, int> resampled_line(min(node1, node2), max(node1, node2));
+                    if (find(resampled_lines.begin(), resampled_lines.end(), resampled_line) == resampled_lines.end()) {
+                        resampled_lines.push_back(resampled_line);
+                    }
+                }
+            }
+        }
+
+        // Get the filled cell bordering the given line, provided the line lies on the boundary of the shape. Otherwise return -1.
+        static int get_boundary_cell_of_line(pair<int, int> line, grd::Densities2d* densities) {
+            int x1 = line.first / (densities->dim_y + 1), y1 = line.first % (densities->dim_y + 1);
+            int x2 = line.second / (densities->dim_y + 1), y2 = line.second % (densities->dim_y + 1);
+            vector<pair<int, int>> adjacent_cells;
+            if (y1 == y2) adjacent_cells = { pair(min(x1, x2), y1 - 1), pair(min(x1, x2), y1) };
+            else adjacent_cells = { pair(x1 - 1, min(y1, y2)), pair(x1, min(y1, y2)) };
+            vector<int> filled_cells;
+            for (auto& [x, y] : adjacent_cells) {
+                if (x < 0 || y < 0 || x >= densities->dim_x || y >= densities->dim_y) continue;
+                if (densities->at(x, y)) filled_cells.push_back(densities->get_idx(x, y));
+            }
+            if (filled_cells.size() != 1) return -1;
+            return filled_cells[0];
+        }
+
+        /*
+        Create a version of the given FEA case manager that fits the grid of the given (resampled) densities object. The source
+        manager should correspond to a grid of source_dim_x x source_dim_y cells covering the same domain.
+        Keep, cutout and inactive cells are mapped onto the new grid, after which the keep- and cutout cells are enforced on the
+        given densities. Boundary lines are mapped onto the new node grid; lines that do not lie on the boundary of the resampled
+        shape are dropped. As in derive_boundary_conditions(), the cells bordering the remaining lines are marked as keep cells
+        and their empty neighbors as cutout cells.
+        */
+        static void resample_fea_casemanager(
+            phys::FEACaseManager* source, int source_dim_x, int source_dim_y, grd::Densities2d* densities,
+            phys::FEACaseManager& target
+        ) {
+            target = *source;
+            target.dim_x = densities->dim_x + 1;
+            target.dim_y = densities->dim_y + 1;
+            auto resample_cells = [&](vector<int>* source_cells, vector<int>& target_cells) {
+                target_cells.clear();
+                for (auto& cell : *source_cells) {
+                    vector<int> resampled_cells;
+                    grd::Densities2d::get_resampled_cells(
+                        cell, source_dim_x, source_dim_y, densities->dim_x, densities->dim_y, resampled_cells
+                    );
+                    for (auto& resampled_cell : resampled_cells) {
+                        if (!help::is_in(&target_cells, resampled_cell)) target_cells.push_back(resampled_cell);
+                    }
+                }
+            };
+            resample_cells(&source->keep_cells, target.keep_cells);
+            resample_cells(&source->cutout_cells, target.cutout_cells);
+            resample_cells(&source->inactive_cells, target.inactive_cells);
+            for (auto& keep_cell : target.keep_cells) help::remove(&target.cutout_cells, keep_cell);
+            if (source->displacement_measurement_cell != -1) {
+                vector<int> resampled_cells;
+                grd::Densities2d::get_resampled_cells(
+                    source->displacement_measurement_cell, source_dim_x, source_dim_y, densities->dim_x, densities->dim_y,
+                    resampled_cells
+                );
+                target.displacement_measurement_cell = resampled_cells[0];
+            }
+            densities->fea_casemanager = &target;
+            densities->enforce_keeps_and_cutouts();
+
+            vector<vector<phys::FEACase>*> case_vectors = { &target.sources, &target.targets, &target.active_cases };
+            for (auto& fea_cases : case_vectors) {
+                for (auto& fea_case : *fea_cases) {
+                    fea_case.dim_x = densities->dim_x;
+                    fea_case.dim_y = densities->dim_y;
+                    for (auto& [bound_name, lines] : fea_case.bound_cond_lines) {
+                        vector<pair<int, int>> resampled_lines, bound_lines;
+                        resample_boundary_lines(
+                            &lines, source_dim_x, source_dim_y, densities->dim_x, densities->dim_y, resampled_lines
+                        );
+                        vector<int> bound_cells, cutout_cells, keep_cells;
+                        for (auto& line : resampled_lines) {
+                            int cell_coord = get_boundary_cell_of_line(line, densities);
+                            if (cell_coord == -1) continue;
+                            bound_lines.push_back(line);
+                            if (!help::is_in(&target.keep_cells, cell_coord)) target.keep_cells.push_back(cell_coord);
+                            if (!help::is_in(&bound_cells, cell_coord)) bound_cells.push_back(cell_coord);
+                            for (auto& void_neighbor : densities->get_empty_neighbors(cell_coord, true)) {
+                                if (!help::is_in(&target.cutout_cells, void_neighbor)) target.cutout_cells.push_back(void_neighbor);
+                                if (!help::is_in(&cutout_cells, void_neighbor)) cutout_cells.push_back(void_neighbor);
+                            }
+                            for (auto& neighbor : densities->get_neighbors(cell_coord)) {
+                                if (!help::is_in(&target.keep_cells, neighbor)) target.keep_cells.push_back(neighbor);
+                                if (!help::is_in(&keep_cells, neighbor)) keep_cells.push_back(neighbor);
+                            }
+                        }
+                        if (bound_lines.empty()) {
+                            cout << "msh: WARNING: None of the lines of boundary condition " << bound_name << " in case "
+                                << fea_case.name << " lie on the boundary of the resampled shape.\n";
+                        }
+                        lines = bound_lines;
+                        fea_case.bound_cond_cells[bound_name]["bound"] = bound_cells;
+                        fea_case.bound_cond_cells[bound_name]["cutout"] = cutout_cells;
+                        fea_case.bound_cond_cells[bound_name]["keep"] = keep_cells;
+                    }
+                }
+            }
+        }
+
         // Create map containing a vector of boundary ids corresponding to the given fe mesh for each boundary condition name
         static void create_bound_id_lookup(
             map<string, vector<pair<int, int>>>* bound_cond_lines, FEMesh2D* fe_mesh, map<string, vector<int>>& bound_id_lookup
@@ -464,14 +620,45 @@ namespace fessga {
             }
             fea_case->content += fea_case->sections[fea_case->names.size()];
 
+            if (fea_casemanager->results_format == "vtu") {
+                // Request double precision VTU output with a raw appended data block, which can be read without conversion.
+                // Elmer appends '_t0001' to the output file name.
+                set_sif_keyword(fea_case->content, "Output Format", "vtu");
+                set_sif_keyword(fea_case->content, "Binary Output", "True");
+                set_sif_keyword(fea_case->content, "Single Precision", "False");
+                set_sif_keyword(fea_case->content, "Output File Name", fea_case->name);
+                return;
+            }
+
             // Replace 'Output File Name' default setting of 'case' with the fea_case's specific case name.
             fea_case->content = help::replace_occurrences(
                 fea_case->content, "Output File Name = case\n", "Output File Name = " + fea_case->name + "_\n");
         }
 
+        // Set the value of the given keyword of the result output solver section in the given case file content. If the
+        // keyword is not present yet, it is added to the section.
+        static void set_sif_keyword(string& content, string keyword, string value) {
+            size_t section_start = content.find("ResultOutputSolve");
+            if (section_start == string::npos) return;
+            section_start = content.rfind("\nSolver ", section_start);
+            size_t section_end = content.find("\nEnd", section_start);
+            if (section_start == string::npos || section_end == string::npos) return;
+            size_t line_start = content.find('\n', section_start + 1) + 1;
+            while (line_start <= section_end) {
+                size_t line_end = content.find('\n', line_start);
+                size_t key_start = content.find_first_not_of(" \t", line_start);
+                if (content.compare(key_start, keyword.size(), keyword) == 0) {
+                    content.replace(key_start, line_end - key_start, keyword + " = " + value);
+                    return;
+                }
+                line_start = line_end + 1;
+            }
+            content.insert(section_end + 1, keyword + " = " + value + "\n");
+        }
+
         static void get_vtk_paths(phys::FEACaseManager* fea_casemanager, string output_folder, vector<string>& vtk_paths) {
             for (auto& fea_case : fea_casemanager->active_cases) {
-                vtk_paths.push_back(output_folder + "/" + fea_case.name + "_0001.vtk");
+                vtk_paths.push_back(output_folder + "/" + fea_casemanager->get_results_filename(fea_case.name));
             }
         }
 
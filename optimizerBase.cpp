@@ -2,7 +2,9 @@
 #include "optimizerBase.h"
 
 
-bool load_physics(grd::Densities2d* densities, msh::SurfaceMesh* mesh, bool verbose) {
+bool load_physics(
+	grd::Densities2d* densities, msh::SurfaceMesh* mesh, bool verbose, bool keep_nodal_results, vector<int>* node_grid_indices
+) {
 	// Obtain vtk file paths
 	vector<string> vtk_paths;
 	msh::get_vtk_paths(densities->fea_casemanager, densities->output_folder, vtk_paths);
@@ -17,17 +19,17 @@ bool load_physics(grd::Densities2d* densities, msh::SurfaceMesh* mesh, bool verb
 	}
 	densities->vtk_paths = vtk_paths;
 
-	// Initialize data map to contain only 0's
-	densities->fea_results.data_map.clear();
-	for (auto& [coord, stress] : densities->fea_results.data_map) cout << "coord: " << coord << endl;
+	// Initialize results to contain only 0's for the filled cells
+	densities->fea_results.reset(densities->dim_x, densities->dim_y);
 	for (int i = 0; i < densities->dim_x * densities->dim_y; i++) {
-		if (densities->at(i)) densities->fea_results.data_map.insert(pair(i, 0));
+		if (densities->at(i)) densities->fea_results.set(i, 0);
 	}
 
 	// Load physics
 	bool physics_loaded = fessga::phys::load_2d_physics_data(
 		vtk_paths, densities->fea_results, densities->fea_casemanager, densities->dim_x, densities->dim_y,
-		densities->cell_size, mesh->offset, densities->fea_casemanager->mechanical_constraint
+		densities->cell_size, mesh->offset, densities->fea_casemanager->mechanical_constraint, keep_nodal_results,
+		node_grid_indices
 	);
 
 	// Check if loading was successful
@@ -11,7 +11,12 @@
 using namespace fessga;
 
 
-bool load_physics(grd::Densities2d* densities, msh::SurfaceMesh* mesh, bool verbose = false);
+// Load the FEA results of the given density distribution. If the node grid indices of its FE mesh are given, point
+// coordinates are mapped to nodes through them (see phys::load_nodal_results).
+bool load_physics(
+	grd::Densities2d* densities, msh::SurfaceMesh* mesh, bool verbose = false, bool keep_nodal_results = false,
+	vector<int>* node_grid_indices = 0
+);
 
 class OptimizerBase {
 public:
@@ -74,6 +79,7 @@ public:
 	virtual void export_meta_parameters(vector<string>* additional_metaparameters) {
 		vector<string> _content = {
 			"max stress threshold = " + to_string(fea_casemanager.max_stress_threshold),
+			"seed = " + to_string(help::get_RNG_seed()),
 		};
 		help::append_vector(_content, additional_metaparameters);
 		string content = help::join(&_content, "\n");
@@ -117,12 +123,17 @@ public:
 		}
 	}
 
-	// Create and export new versions of the case.sif files by updating the boundary ids to fit the topology of the current FE mesh
-	void create_sif_files(grd::Densities2d* densities, msh::FEMesh2D* fe_mesh, bool verbose = false) {
-		densities->fea_casemanager->update_casepaths(densities->output_folder);
-		for (auto& fea_case : densities->fea_casemanager->active_cases) {
+	// Create and export new versions of the case.sif files by updating the boundary ids to fit the topology of the current FE mesh.
+	// The shared FEA cases are left untouched, so that the case files of several individuals can be created concurrently.
+	static void create_sif_files(grd::Densities2d* densities, msh::FEMesh2D* fe_mesh, bool verbose = false) {
+		for (auto& source_case : densities->fea_casemanager->active_cases) {
+			phys::FEACase fea_case;
+			fea_case.name = source_case.name;
+			fea_case.names = source_case.names;
+			fea_case.sections = source_case.sections;
+			fea_case.path = densities->output_folder + "/" + fea_case.name + ".sif";
 			map<string, vector<int>> bound_id_lookup;
-			msh::create_bound_id_lookup(&fea_case.bound_cond_lines, fe_mesh, bound_id_lookup);
+			msh::create_bound_id_lookup(&source_case.bound_cond_lines, fe_mesh, bound_id_lookup);
 			msh::assemble_fea_case(densities->fea_casemanager, &fea_case, &bound_id_lookup);
 			IO::write_text_to_file(fea_case.content, fea_case.path);
 			if (verbose) cout << "-- Exported case file to path " << fea_case.path << endl;
@@ -592,3 +592,1039 @@ void phys::FEACaseManager::update_casepaths(string case_folder) {
 	}
 }
 
+/*
+Solve the given FEA case (see call_elmer_case) until its results file appears, following the given retry policy. The
+results file is awaited by sleeping between checks, with the interval doubling after every check, so waiting takes no CPU
+time. Return whether the results file was produced.
+*/
+bool phys::solve_elmer_case(string case_folder, string case_name, string results_path, RetryPolicy policy, bool verbose) {
+	for (int attempt = 1; attempt <= policy.max_attempts; attempt++) {
+		if (attempt > 1) this_thread::sleep_for(chrono::duration<double>(policy.retry_delay));
+		call_elmer_case(case_folder, case_name, verbose);
+		auto deadline = chrono::steady_clock::now() + chrono::duration<double>(policy.results_timeout);
+		auto interval = chrono::milliseconds(1);
+		while (!IO::file_exists(results_path)) {
+			if (chrono::steady_clock::now() >= deadline) break;
+			this_thread::sleep_for(interval);
+			interval = min(interval * 2, chrono::milliseconds(500));
+		}
+		if (IO::file_exists(results_path)) return true;
+		cout << "- WARNING:   Attempt " << attempt << " / " << policy.max_attempts << " to produce a results file failed on case '"
+			<< results_path << "'\n";
+	}
+	return false;
+}
+
+// Get the name of the results file Elmer writes for the given case (see msh::assemble_fea_case)
+string phys::FEACaseManager::get_results_filename(string case_name) {
+	if (results_format == "vtu") return case_name + "_t0001.vtu";
+	return case_name + "_0001.vtk";
+}
+
+
+// Read a value of type T from the given bytes, which are in host byte order and need not be aligned
+template <typename T>
+static double read_value(const char* bytes) {
+	T value;
+	memcpy(&value, bytes, sizeof(T));
+	return (double)value;
+}
+
+// Cursor over the contents of a memory-mapped legacy VTK file
+struct VTKCursor {
+	const char* position;
+	const char* end;
+	bool binary = false;
+
+	void skip_whitespace() {
+		while (position < end && isspace((unsigned char)*position)) position++;
+	}
+	string_view next_token() {
+		skip_whitespace();
+		const char* start = position;
+		while (position < end && !isspace((unsigned char)*position)) position++;
+		return string_view(start, position - start);
+	}
+	// Get the next token on the current line, or an empty token if the line ends first
+	string_view next_token_on_line() {
+		while (position < end && (*position == ' ' || *position == '\t' || *position == '\r')) position++;
+		if (position == end || *position == '\n') return string_view();
+		return next_token();
+	}
+	size_t next_size() {
+		string_view token = next_token();
+		size_t value = 0;
+		from_chars(token.data(), token.data() + token.size(), value);
+		return value;
+	}
+	void skip_line() {
+		while (position < end && *position != '\n') position++;
+		if (position < end) position++;
+	}
+	static int get_type_size(string_view type) {
+		if (type == "double" || type == "long" || type == "unsigned_long" || type == "vtktypeint64" || type == "vtktypeuint64" ||
+			type == "int64" || type == "uint64") return 8;
+		if (type == "float" || type == "int" || type == "unsigned_int" || type == "int32" || type == "uint32") return 4;
+		if (type == "short" || type == "unsigned_short" || type == "int16" || type == "uint16") return 2;
+		if (type == "char" || type == "unsigned_char" || type == "int8" || type == "uint8" || type == "bit") return 1;
+		return 0;
+	}
+	// Read a single big-endian binary value of the given size and type
+	static double decode(const char* bytes, int size, string_view type) {
+		char swapped[8];
+		for (int i = 0; i < size; i++) swapped[i] = bytes[size - 1 - i];
+		if (type == "double") return read_value<double>(swapped);
+		if (type == "float") return read_value<float>(swapped);
+		bool is_unsigned = type[0] == 'u';
+		if (size == 8) return is_unsigned ? read_value<uint64_t>(swapped) : read_value<int64_t>(swapped);
+		if (size == 4) return is_unsigned ? read_value<uint32_t>(swapped) : read_value<int32_t>(swapped);
+		if (size == 2) return is_unsigned ? read_value<uint16_t>(swapped) : read_value<int16_t>(swapped);
+		return is_unsigned ? read_value<uint8_t>(swapped) : read_value<int8_t>(swapped);
+	}
+	// Read <count> values of the given type, passing each to <callback>(index, value)
+	template <typename Callback>
+	bool read_values(size_t count, string_view type, Callback callback) {
+		if (binary) {
+			int size = get_type_size(type);
+			skip_line(); // Binary data starts on the line following the section header
+			if (size == 0 || position + count * size > end) return false;
+			for (size_t i = 0; i < count; i++) callback(i, decode(position + i * size, size, type));
+			position += count * size;
+			return true;
+		}
+		for (size_t i = 0; i < count; i++) {
+			skip_whitespace();
+			if (position < end && *position == '+') position++;
+			double value;
+			auto [next, error] = from_chars(position, end, value);
+			if (error != errc()) return false;
+			position = next;
+			callback(i, value);
+		}
+		return true;
+	}
+	bool skip_values(size_t count, string_view type) {
+		if (binary) {
+			int size = get_type_size(type);
+			skip_line();
+			if (size == 0 || position + count * size > end) return false;
+			position += count * size;
+			return true;
+		}
+		// Rather than tokenizing the skipped values, jump to the next line that starts with a keyword (all keywords are
+		// upper case, whereas values are numbers)
+		while (position < end) {
+			const char* line_end = (const char*)memchr(position, '\n', end - position);
+			if (line_end == nullptr) {
+				position = end;
+				break;
+			}
+			position = line_end + 1;
+			const char* line_start = position;
+			while (line_start < end && (*line_start == ' ' || *line_start == '\t')) line_start++;
+			if (line_start < end && *line_start >= 'A' && *line_start <= 'Z') break;
+		}
+		return true;
+	}
+};
+
+// Computes the node grid index of each point from its coordinates, which are passed one component at a time. If
+// <check_stride> is set, the coordinates already hold the expected node indices, and only every <check_stride>th point is
+// computed and compared to them.
+struct PointCoordinateWriter {
+	vector<int>* coords;
+	Vector2d inv_cell_size;
+	Vector2d offset;
+	int dim_y;
+	size_t check_stride = 0;
+	bool* mismatch = nullptr;
+	double point[3];
+
+	void operator()(size_t i, double value) {
+		point[i % 3] = value;
+		if (i % 3 != 1) return;
+		size_t point_index = i / 3;
+		if (check_stride && point_index % check_stride) return;
+		Vector2d gridscale_coord = inv_cell_size.cwiseProduct(Vector2d(point[0], point[1]) - offset);
+		int node = round(gridscale_coord[0]) * (dim_y + 1) + round(gridscale_coord[1]);
+		if (!check_stride) coords->at(point_index) = node;
+		else if (coords->at(point_index) != node) *mismatch = true;
+	}
+};
+
+// Fill <coords> with the node grid index of each point, reading the point coordinates with <read_coordinates>(writer).
+// If the node grid indices of the FE mesh are given and match the number of points (Elmer keeps the node order of the
+// mesh), they are copied and only a sample of the points is verified. Otherwise, or if the sample does not match, the
+// index of each point is computed from its coordinates.
+template <typename Reader>
+static bool read_point_coordinates(
+	vector<int>& coords, size_t no_points, vector<int>* node_grid_indices, Vector2d inv_cell_size, Vector2d offset,
+	int dim_y, Reader read_coordinates
+) {
+	PointCoordinateWriter coordinate_writer{ &coords, inv_cell_size, offset, dim_y };
+	if (node_grid_indices != nullptr && no_points > 0 && node_grid_indices->size() == no_points) {
+		bool mismatch = false;
+		coords = *node_grid_indices;
+		coordinate_writer.check_stride = max((size_t)1, no_points / 256);
+		coordinate_writer.mismatch = &mismatch;
+		if (!read_coordinates(coordinate_writer)) return false;
+		if (!mismatch) return true;
+		coordinate_writer.check_stride = 0;
+	}
+	else coords.assign(no_points, 0);
+	return read_coordinates(coordinate_writer);
+}
+
+// Writes the values of a point data array, which are passed one component at a time, to the node-indexed buffers of
+// the given target (see phys::NodalArrayTarget)
+struct PointArrayWriter {
+	phys::NodalArrayTarget* target;
+	vector<int>* coords;
+	size_t no_nodes;
+	size_t no_components;
+	bool is_displacement;
+	double displacement_x = 0;
+
+	void store(int node, double value) {
+		if (node < 0 || node >= no_nodes) return;
+		if (target->values) target->values[node] = value;
+		if (target->maxima) target->maxima[node] = max(target->maxima[node], value);
+		if (target->minima) target->minima[node] = min(target->minima[node], value);
+	}
+	void operator()(size_t i, double value) {
+		size_t point = i / no_components;
+		size_t component = i % no_components;
+		if (point >= coords->size()) return;
+		if (is_displacement) {
+			if (component == 0) displacement_x = value;
+			else if (component == 1) store(coords->at(point), Vector2d(displacement_x, value).norm());
+		}
+		else if (component == 0) store(coords->at(point), value);
+	}
+};
+
+// Get the value of the given attribute of an XML tag, or an empty string if the tag does not have the attribute
+static string_view get_xml_attribute(string_view tag, string_view attribute) {
+	size_t start = tag.find(attribute);
+	while (start != string_view::npos) {
+		size_t value_start = start + attribute.size();
+		if (isspace((unsigned char)tag[start - 1]) && tag.substr(value_start, 2) == "=\"") {
+			value_start += 2;
+			return tag.substr(value_start, tag.find('"', value_start) - value_start);
+		}
+		start = tag.find(attribute, value_start);
+	}
+	return string_view();
+}
+
+static int get_vtu_type_size(string_view type) {
+	if (type == "Float64" || type == "Int64" || type == "UInt64") return 8;
+	if (type == "Float32" || type == "Int32" || type == "UInt32") return 4;
+	if (type == "Int16" || type == "UInt16") return 2;
+	if (type == "Int8" || type == "UInt8") return 1;
+	return 0;
+}
+
+// Read a single binary value of the given VTU data type
+static double decode_vtu_value(const char* bytes, string_view type, int size, bool big_endian) {
+	char value[8];
+	for (int i = 0; i < size; i++) value[i] = big_endian ? bytes[size - 1 - i] : bytes[i];
+	if (type == "Float64") return read_value<double>(value);
+	if (type == "Float32") return read_value<float>(value);
+	bool is_unsigned = type[0] == 'U';
+	if (size == 8) return is_unsigned ? read_value<uint64_t>(value) : read_value<int64_t>(value);
+	if (size == 4) return is_unsigned ? read_value<uint32_t>(value) : read_value<int32_t>(value);
+	if (size == 2) return is_unsigned ? read_value<uint16_t>(value) : read_value<int16_t>(value);
+	return is_unsigned ? read_value<uint8_t>(value) : read_value<int8_t>(value);
+}
+
+/*
+Read the requested point arrays from a VTU file. Arrays may be stored inline as ASCII or in an uncompressed raw appended
+data block (as written by Elmer with 'Binary Output = True'). Appended values are read in place from the mapped file;
+little-endian Float64 values are copied without conversion.
+*/
+static bool load_vtu_nodal_results(
+	IO::MappedFile* file, phys::NodalResults2D& nodal_results, int dim_x, int dim_y, Vector2d cell_size, Vector2d offset,
+	vector<phys::NodalArrayTarget>& targets, vector<int>* node_grid_indices
+) {
+	string_view content(file->data, file->size);
+	auto get_tag = [&](size_t tag_start) { return content.substr(tag_start, content.find('>', tag_start) - tag_start); };
+	size_t file_tag_start = content.find("<VTKFile");
+	size_t piece_start = content.find("<Piece");
+	if (file_tag_start == string_view::npos || piece_start == string_view::npos) return false;
+	string_view file_tag = get_tag(file_tag_start);
+	if (!get_xml_attribute(file_tag, "compressor").empty()) {
+		cout << "phys: ERROR: Compressed .vtu files are not supported.\n";
+		return false;
+	}
+	bool big_endian = get_xml_attribute(file_tag, "byte_order") == "BigEndian";
+	int header_size = get_xml_attribute(file_tag, "header_type") == "UInt64" ? 8 : 4;
+
+	// The raw appended data starts after an underscore
+	const char* appended_data = nullptr;
+	size_t appended_start = content.find("<AppendedData");
+	if (appended_start != string_view::npos) {
+		string_view appended_tag = get_tag(appended_start);
+		if (get_xml_attribute(appended_tag, "encoding") != "raw") {
+			cout << "phys: ERROR: Only raw encoding of appended data is supported for .vtu files.\n";
+			return false;
+		}
+		appended_data = file->data + content.find('_', appended_start + appended_tag.size()) + 1;
+	}
+
+	// Read the values of the data array with the given opening tag
+	auto read_data_array = [&](size_t tag_start, size_t count, auto callback) {
+		string_view tag = get_tag(tag_start);
+		string_view type = get_xml_attribute(tag, "type");
+		string_view format = get_xml_attribute(tag, "format");
+		if (format == "appended" && appended_data != nullptr) {
+			size_t array_offset = 0;
+			string_view offset_string = get_xml_attribute(tag, "offset");
+			from_chars(offset_string.data(), offset_string.data() + offset_string.size(), array_offset);
+			int size = get_vtu_type_size(type);
+			const char* values = appended_data + array_offset + header_size;
+			if (size == 0 || values + count * size > file->data + file->size) return false;
+			if (type == "Float64" && !big_endian) {
+				for (size_t i = 0; i < count; i++) callback(i, read_value<double>(values + i * sizeof(double)));
+			}
+			else for (size_t i = 0; i < count; i++) callback(i, decode_vtu_value(values + i * size, type, size, big_endian));
+			return true;
+		}
+		else if (format == "ascii") {
+			const char* position = file->data + tag_start + tag.size() + 1;
+			const char* end = file->data + file->size;
+			for (size_t i = 0; i < count; i++) {
+				while (position < end && isspace((unsigned char)*position)) position++;
+				double value;
+				auto [next, error] = from_chars(position, end, value);
+				if (error != errc()) return false;
+				position = next;
+				callback(i, value);
+			}
+			return true;
+		}
+		cout << "phys: ERROR: Unsupported data array format '" << format << "' in .vtu file.\n";
+		return false;
+	};
+
+	// Read point coordinates
+	string_view no_points_string = get_xml_attribute(get_tag(piece_start), "NumberOfPoints");
+	size_t no_points = 0;
+	from_chars(no_points_string.data(), no_points_string.data() + no_points_string.size(), no_points);
+	size_t points_start = content.find("<Points", piece_start);
+	if (points_start == string_view::npos) return false;
+	size_t coordinates_start = content.find("<DataArray", points_start);
+	bool success = read_point_coordinates(
+		nodal_results.coords, no_points, node_grid_indices, Vector2d(1.0 / cell_size(0), 1.0 / cell_size(1)), offset, dim_y,
+		[&](PointCoordinateWriter coordinate_writer) {
+			return read_data_array(coordinates_start, 3 * no_points, coordinate_writer);
+		}
+	);
+	if (!success) return false;
+
+	// Read requested point data arrays. Array names are compared case-insensitively.
+	size_t point_data_start = content.find("<PointData", piece_start);
+	if (point_data_start == string_view::npos) return true;
+	size_t point_data_end = content.find("</PointData>", point_data_start);
+	if (point_data_end == string_view::npos) return false;
+	nodal_results.point_data_offset = point_data_start;
+	nodal_results.point_data_end = point_data_end + string_view("</PointData>").size();
+	auto is_equal = [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); };
+	for (size_t tag_start = content.find("<DataArray", point_data_start); tag_start < point_data_end;
+		tag_start = content.find("<DataArray", tag_start + 1)
+	) {
+		string_view tag = get_tag(tag_start);
+		string_view name = get_xml_attribute(tag, "Name");
+		auto target = find_if(targets.begin(), targets.end(), [&](phys::NodalArrayTarget& requested) {
+			return equal(requested.name.begin(), requested.name.end(), name.begin(), name.end(), is_equal);
+		});
+		if (target == targets.end()) continue;
+		string_view components_string = get_xml_attribute(tag, "NumberOfComponents");
+		size_t no_components = 1;
+		if (!components_string.empty()) from_chars(components_string.data(), components_string.data() + components_string.size(), no_components);
+		PointArrayWriter array_writer{
+			&*target, &nodal_results.coords, (size_t)(dim_x + 1) * (dim_y + 1), no_components,
+			target->name == "Displacement" && no_components > 1
+		};
+		if (!read_data_array(tag_start, no_components * no_points, array_writer)) return false;
+	}
+	return true;
+}
+
+bool phys::load_nodal_results(
+	string filename, NodalResults2D& nodal_results, int dim_x, int dim_y, Vector2d cell_size, Vector2d offset,
+	vector<NodalArrayTarget>& targets, vector<int>* node_grid_indices
+) {
+	nodal_results.coords.clear();
+	nodal_results.path = filename;
+	nodal_results.point_data_offset = 0;
+	nodal_results.point_data_end = 0;
+
+	IO::MappedFile file(filename);
+	if (file.data == nullptr) {
+		cout << "phys: ERROR: Unable to open results file " << filename << endl;
+		return false;
+	}
+	if (help::ends_with(filename, ".vtu")) {
+		bool success = load_vtu_nodal_results(&file, nodal_results, dim_x, dim_y, cell_size, offset, targets, node_grid_indices);
+		if (!success) cout << "phys: ERROR: Unable to parse .vtu file " << filename << endl;
+		return success;
+	}
+	VTKCursor cursor{ file.data, file.data + file.size };
+	cursor.skip_line(); // Version
+	cursor.skip_line(); // Title
+	cursor.binary = cursor.next_token() == "BINARY";
+	nodal_results.binary = cursor.binary;
+
+	Vector2d inv_cell_size = Vector2d(1.0 / cell_size(0), 1.0 / cell_size(1));
+	size_t section_size = 0;
+	bool in_point_data = false;
+	bool success = true;
+
+	// Read the values of a data array, keeping only the requested point arrays
+	auto read_array = [&](string_view name, string_view type, size_t no_components, size_t no_tuples) {
+		auto target = find_if(targets.begin(), targets.end(), [&](NodalArrayTarget& requested) { return requested.name == name; });
+		if (!in_point_data || target == targets.end()) return cursor.skip_values(no_components * no_tuples, type);
+		PointArrayWriter array_writer{
+			&*target, &nodal_results.coords, (size_t)(dim_x + 1) * (dim_y + 1), no_components,
+			name == "Displacement" && no_components > 1
+		};
+		return cursor.read_values(no_components * no_tuples, type, array_writer);
+	};
+
+	while (success) {
+		cursor.skip_whitespace();
+		const char* section_start = cursor.position;
+		string_view keyword = cursor.next_token();
+		if (keyword.empty()) break;
+		if (keyword == "DATASET") cursor.next_token();
+		else if (keyword == "POINTS") {
+			size_t no_points = cursor.next_size();
+			string_view type = cursor.next_token();
+			const char* values_start = cursor.position;
+			success = read_point_coordinates(
+				nodal_results.coords, no_points, node_grid_indices, inv_cell_size, offset, dim_y,
+				[&](PointCoordinateWriter coordinate_writer) {
+					cursor.position = values_start;
+					return cursor.read_values(3 * no_points, type, coordinate_writer);
+				}
+			);
+		}
+		else if (keyword == "CELLS") {
+			size_t no_cells = cursor.next_size();
+			size_t size = cursor.next_size();
+			const char* header_end = cursor.position;
+			if (cursor.next_token() == "OFFSETS") {
+				// Files of version 5 and up store cells as separate arrays of offsets and connectivity
+				success = cursor.skip_values(no_cells, cursor.next_token());
+				if (success && cursor.next_token() == "CONNECTIVITY") success = cursor.skip_values(size, cursor.next_token());
+			}
+			else {
+				cursor.position = header_end;
+				success = cursor.skip_values(size, "int");
+			}
+		}
+		else if (keyword == "CELL_TYPES") success = cursor.skip_values(cursor.next_size(), "int");
+		else if (keyword == "POINT_DATA" || keyword == "CELL_DATA") {
+			in_point_data = keyword == "POINT_DATA";
+			section_size = cursor.next_size();
+			if (in_point_data) nodal_results.point_data_offset = section_start - file.data;
+		}
+		else if (keyword == "SCALARS" || keyword == "VECTORS" || keyword == "NORMALS" || keyword == "TENSORS") {
+			string_view name = cursor.next_token();
+			string_view type = cursor.next_token();
+			size_t no_components = keyword == "TENSORS" ? 9 : (keyword == "SCALARS" ? 1 : 3);
+			string_view components = cursor.next_token_on_line();
+			if (!components.empty()) from_chars(components.data(), components.data() + components.size(), no_components);
+			if (keyword == "SCALARS") {
+				// Scalars are followed by a lookup table declaration
+				const char* header_end = cursor.position;
+				if (cursor.next_token() == "LOOKUP_TABLE") cursor.next_token();
+				else cursor.position = header_end;
+			}
+			success = read_array(name, type, no_components, section_size);
+		}
+		else if (keyword == "FIELD") {
+			cursor.next_token();
+			size_t no_arrays = cursor.next_size();
+			for (size_t i = 0; i < no_arrays && success; i++) {
+				string_view name = cursor.next_token();
+				size_t no_components = cursor.next_size();
+				size_t no_tuples = cursor.next_size();
+				string_view type = cursor.next_token();
+				success = read_array(name, type, no_components, no_tuples);
+			}
+		}
+		else if (keyword == "LOOKUP_TABLE") {
+			cursor.next_token();
+			size_t size = cursor.next_size();
+			success = cursor.skip_values(4 * size, cursor.binary ? "unsigned_char" : "float");
+		}
+		else if (keyword == "METADATA") {
+			// Metadata blocks are terminated by an empty line
+			cursor.skip_line();
+			while (cursor.position < cursor.end && cursor.next_token_on_line().size()) cursor.skip_line();
+		}
+		else success = false;
+	}
+	if (!success) cout << "phys: ERROR: Unable to parse .vtk file " << filename << endl;
+
+	return success;
+}
+
+/*
+Compute the cell means of the node grid field in a single sweep over pairs of adjacent node rows (a row being the dim_y + 1
+nodes with the same x-index). The sum of each cell's corners is obtained by adding the two rows column-wise and then adding
+adjacent columns. Cells that have a corner of value 0 or that are marked as inactive are masked out by giving them a lower
+bound of -infinity (and an upper bound of infinity), so that the fold into <results> and the reductions need no branches
+and the inner loop can be vectorized.
+*/
+bool phys::fold_cellwise_results(
+	vector<double>* nodewise_values, vector<uint8_t>* inactive_mask, FEAResults2D* results, FEACaseManager* fea_casemanager,
+	int dim_x, int dim_y, string mechanical_constraint
+) {
+	int row_size = dim_y + 1;
+	if (nodewise_values->size() != (dim_x + 1) * row_size || inactive_mask->size() != dim_x * dim_y) return false;
+	const double* nodes = nodewise_values->data();
+	const uint8_t* inactive = inactive_mask->data();
+
+	if (mechanical_constraint == "Displacement") {
+		// Only the cell at which the displacement is measured is considered
+		int cell = fea_casemanager->displacement_measurement_cell;
+		if (cell < 0 || cell >= dim_x * dim_y || inactive[cell]) return true;
+		const double* row = nodes + (cell / dim_y) * row_size + cell % dim_y;
+		if (row[0] == 0 || row[1] == 0 || row[row_size] == 0 || row[row_size + 1] == 0) return true;
+		double cell_value = 0.25 * (row[0] + row[1] + row[row_size] + row[row_size + 1]);
+		results->set(cell, max(results->get(cell), cell_value));
+		if (cell_value > results->max) results->max = cell_value;
+		return true;
+	}
+
+	double min_value = 1e30;
+	double max_value = 0;
+	for (int x = 0; x < dim_x; x++) {
+		const double* row1 = nodes + x * row_size;
+		const double* row2 = row1 + row_size;
+		const uint8_t* inactive_row = inactive + x * dim_y;
+		double* cell_row = results->values.data() + x * dim_y;
+		uint8_t* valid_row = results->valid.data() + x * dim_y;
+		for (int y = 0; y < dim_y; y++) {
+			double mean = 0.25 * ((row1[y] + row2[y]) + (row1[y + 1] + row2[y + 1]));
+			bool is_masked = (row1[y] == 0) | (row2[y] == 0) | (row1[y + 1] == 0) | (row2[y + 1] == 0) | (inactive_row[y] != 0);
+			double lower = is_masked ? -INFINITY : mean;
+			double upper = is_masked ? INFINITY : mean;
+
+			// Cells without a valid value have value 0, so taking the maximum with the current value is equivalent to using get()
+			cell_row[y] = max(cell_row[y], lower);
+			valid_row[y] |= !is_masked;
+			max_value = max(max_value, lower);
+			min_value = min(min_value, upper);
+		}
+	}
+	if (min_value < results->min) results->min = min_value;
+	if (max_value > results->max) results->max = max_value;
+
+	return true;
+}
+
+// Append <count> values, obtained from <get_value> by index, to <content> in legacy VTK format
+template <typename T>
+static void append_vtk_values(string& content, size_t count, T get_value, bool binary) {
+	if (binary) {
+		size_t start = content.size();
+		content.resize(start + count * sizeof(double));
+		for (size_t i = 0; i < count; i++) {
+			double value = get_value(i);
+			char* bytes = (char*)&value;
+			for (int j = 0; j < sizeof(double); j++) content[start + i * sizeof(double) + j] = bytes[sizeof(double) - 1 - j];
+		}
+		content += "\n";
+		return;
+	}
+	char buffer[32];
+	for (size_t i = 0; i < count; i++) {
+		auto [end, error] = to_chars(buffer, buffer + sizeof(buffer), get_value(i));
+		content.append(buffer, end - buffer);
+		content += "\n";
+	}
+}
+
+bool phys::write_results_superposition(NodalSuperposition2D* superposition, int dim_x, int dim_y, string outfile) {
+	if (superposition->empty() || superposition->displacements.size() != (dim_x + 1) * (dim_y + 1)) {
+		cout << "phys: ERROR: No nodal results available to write superposition to " << outfile << endl;
+		return false;
+	}
+
+	// Per point of the first run, write the stress components with the largest absolute value. The displacement
+	// magnitude is stored in the z-component of the displacement vectors. Values are read from the superposition's
+	// buffers while writing, so no per-point copies are made.
+	NodalResults2D* template_results = &superposition->layout;
+	vector<int>& coords = template_results->coords;
+	size_t no_points = coords.size();
+	auto stress_xx = [&](size_t i) {
+		int coord = coords[i];
+		double tensile = superposition->tensile_xx[coord], compressive = superposition->compressive_xx[coord];
+		return tensile > -compressive ? tensile : compressive;
+	};
+	auto stress_yy = [&](size_t i) {
+		int coord = coords[i];
+		double tensile = superposition->tensile_yy[coord], compressive = superposition->compressive_yy[coord];
+		return tensile > -compressive ? tensile : compressive;
+	};
+	auto displacements = [&](size_t i) { return i % 3 == 2 ? superposition->displacements[coords[i / 3]] : 0.0; };
+
+	// Copy the geometry sections of the first run's file and append the superposed point data
+	IO::MappedFile template_file(template_results->path);
+	if (template_file.data == nullptr || template_file.size < max(template_results->point_data_offset, template_results->point_data_end)) {
+		cout << "phys: ERROR: Unable to read template file " << template_results->path << endl;
+		return false;
+	}
+	string content(template_file.data, template_results->point_data_offset);
+	if (help::ends_with(template_results->path, ".vtu")) {
+		// Replace the <PointData> element by inline ASCII arrays. The appended data block is copied unchanged, so that
+		// the offsets of the remaining arrays stay valid.
+		auto append_data_array = [&](string name, auto get_value, int no_components) {
+			content += "<DataArray type=\"Float64\" Name=\"" + name + "\" NumberOfComponents=\"" + to_string(no_components)
+				+ "\" format=\"ascii\">\n";
+			append_vtk_values(content, no_components * no_points, get_value, false);
+			content += "</DataArray>\n";
+		};
+		content += "<PointData>\n";
+		append_data_array("Stress_xx", stress_xx, 1);
+		append_data_array("Stress_yy", stress_yy, 1);
+		append_data_array("Displacement", displacements, 3);
+		content += "</PointData>";
+		content.append(
+			template_file.data + template_results->point_data_end, template_file.size - template_results->point_data_end
+		);
+	}
+	else {
+		content += "POINT_DATA " + to_string(no_points) + "\n";
+		content += "SCALARS Stress_xx double\nLOOKUP_TABLE default\n";
+		append_vtk_values(content, no_points, stress_xx, template_results->binary);
+		content += "SCALARS Stress_yy double\nLOOKUP_TABLE default\n";
+		append_vtk_values(content, no_points, stress_yy, template_results->binary);
+		content += "VECTORS Displacement double\n";
+		append_vtk_values(content, 3 * no_points, displacements, template_results->binary);
+	}
+
+	// Write to vtk OUTFILE
+	ofstream file(outfile, ios::binary);
+	file.write(content.data(), content.size());
+
+	return true;
+}
+
+bool phys::write_results_superposition(SuperpositionReference* reference) {
+	NodalSuperposition2D superposition;
+	superposition.reset((reference->dim_x + 1) * (reference->dim_y + 1));
+	vector<NodalArrayTarget> targets = {
+		{ "Stress_xx", nullptr, superposition.tensile_xx.data(), superposition.compressive_xx.data() },
+		{ "Stress_yy", nullptr, superposition.tensile_yy.data(), superposition.compressive_yy.data() },
+		{ "Displacement", nullptr, superposition.displacements.data() }
+	};
+	NodalResults2D nodal_results;
+	for (int i = 0; i < reference->filenames.size(); i++) {
+		bool success = load_nodal_results(
+			reference->filenames[i], nodal_results, reference->dim_x, reference->dim_y, reference->cell_size, reference->offset, targets
+		);
+		if (!success) return false;
+		if (i == 0) superposition.layout = nodal_results;
+	}
+	return write_results_superposition(&superposition, reference->dim_x, reference->dim_y, reference->outfile);
+}
+
+// Accumulates a 128-bit hash over a stream of 64-bit words, using two multiply-rotate lanes with different seeds and
+// constants that are combined and finalized with the MurmurHash3 64-bit mixer
+struct Hash128 {
+	uint64_t h1 = 0x243F6A8885A308D3ULL, h2 = 0x13198A2E03707344ULL;
+	uint64_t length = 0;
+
+	static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+	static uint64_t fmix(uint64_t k) {
+		k ^= k >> 33; k *= 0xFF51AFD7ED558CCDULL;
+		k ^= k >> 33; k *= 0xC4CEB9FE1A85EC53ULL;
+		k ^= k >> 33;
+		return k;
+	}
+	void add(uint64_t word) {
+		h1 ^= rotl(word * 0x87C37B91114253D5ULL, 31) * 0x4CF5AD432745937FULL;
+		h1 = rotl(h1, 27) * 5 + 0x52DCE729;
+		h2 ^= rotl(word * 0x4CF5AD432745937FULL, 33) * 0x87C37B91114253D5ULL;
+		h2 = rotl(h2, 31) * 5 + 0x38495AB5;
+		length++;
+	}
+	void add(string_view text) {
+		for (size_t i = 0; i < text.size(); i += 8) {
+			uint64_t word = 0;
+			memcpy(&word, text.data() + i, min((size_t)8, text.size() - i));
+			add(word);
+		}
+		add((uint64_t)text.size());
+	}
+	phys::FEAResultsCache::Key get() const {
+		uint64_t _h1 = h1 ^ length, _h2 = h2 ^ length;
+		_h1 += _h2; _h2 += _h1;
+		_h1 = fmix(_h1); _h2 = fmix(_h2);
+		_h1 += _h2; _h2 += _h1;
+		return { _h1, _h2 };
+	}
+};
+
+// Compute the hash of everything besides the density distribution that determines the FEA results: the solver, the
+// evaluated quantity, the inactive cells and, per active case, its (load and material) sections and boundary lines.
+void phys::FEAResultsCache::set_context(FEACaseManager* fea_casemanager, string solver) {
+	Hash128 hash;
+	hash.add(solver);
+	hash.add(fea_casemanager->mechanical_constraint);
+	for (auto& cell : fea_casemanager->inactive_cells) hash.add((uint64_t)cell);
+	for (auto& fea_case : fea_casemanager->active_cases) {
+		hash.add(fea_case.name);
+		for (auto& section : fea_case.sections) hash.add(section);
+		for (auto& [bound_name, lines] : fea_case.bound_cond_lines) {
+			hash.add(bound_name);
+			for (auto& line : lines) hash.add(((uint64_t)line.first << 32) | (uint64_t)(uint32_t)line.second);
+		}
+	}
+	context = hash.get();
+}
+
+phys::FEAResultsCache::Key phys::FEAResultsCache::get_key(uint* values, int size, int dim_x, int dim_y) const {
+	Hash128 hash;
+	hash.add(context.low);
+	hash.add(context.high);
+	hash.add(((uint64_t)dim_x << 32) | (uint64_t)dim_y);
+
+	// Pack the density distribution into 64 cells per word
+	uint64_t word = 0;
+	for (int i = 0; i < size; i++) {
+		word |= (uint64_t)(values[i] != 0) << (i % 64);
+		if (i % 64 == 63 || i == size - 1) {
+			hash.add(word);
+			word = 0;
+		}
+	}
+	return hash.get();
+}
+
+// Copy the cached results for the given key (if any) into <results>
+bool phys::FEAResultsCache::fetch(Key key, FEAResults2D& results) {
+	if (capacity <= 0) return false;
+	no_lookups++;
+	auto it = index.find(key);
+	if (it == index.end()) return false;
+	Entry& entry = entries[it->second];
+	entry.last_use = ++clock;
+	results = entry.results;
+	no_hits++;
+	return true;
+}
+
+void phys::FEAResultsCache::insert(Key key, FEAResults2D* results, int iteration) {
+	if (capacity <= 0) return;
+	int slot;
+	auto it = index.find(key);
+	if (it != index.end()) slot = it->second;
+	else if (entries.size() < capacity) {
+		slot = entries.size();
+		entries.push_back(Entry());
+	}
+	else {
+		// Evict the least recently used entry
+		slot = 0;
+		for (int i = 1; i < entries.size(); i++) if (entries[i].last_use < entries[slot].last_use) slot = i;
+		index.erase(entries[slot].key);
+	}
+	Entry& entry = entries[slot];
+	entry.key = key;
+	entry.results = *results;
+	entry.results.case_fields.clear();
+	entry.iteration = iteration;
+	entry.last_use = ++clock;
+	index[key] = slot;
+}
+
+static const char FEA_CACHE_MAGIC[8] = { 'F', 'E', 'A', 'C', 'A', 'C', 'H', '1' };
+
+/*
+Write the cache to <path>. Layout: magic, number of entries, and per entry the key, iteration, grid dimensions,
+min and max, the values, the validity mask and the sensitivities.
+*/
+bool phys::FEAResultsCache::save() const {
+	if (path == "") return false;
+	ofstream file(path, ios::binary);
+	if (!file) {
+		cout << "phys: ERROR: Unable to write FEA results cache to " << path << endl;
+		return false;
+	}
+	auto write = [&](const void* data, size_t size) { file.write((const char*)data, size); };
+	write(FEA_CACHE_MAGIC, sizeof(FEA_CACHE_MAGIC));
+	uint64_t no_entries = entries.size();
+	write(&no_entries, sizeof(no_entries));
+	for (auto& entry : entries) {
+		const FEAResults2D& results = entry.results;
+		int32_t header[3] = { entry.iteration, results.x, results.y };
+		uint64_t no_sensitivities = results.sensitivities.size();
+		write(&entry.key, sizeof(entry.key));
+		write(header, sizeof(header));
+		write(&results.min, sizeof(double));
+		write(&results.max, sizeof(double));
+		write(results.values.data(), results.values.size() * sizeof(double));
+		write(results.valid.data(), results.valid.size());
+		write(&no_sensitivities, sizeof(no_sensitivities));
+		write(results.sensitivities.data(), no_sensitivities * sizeof(double));
+	}
+	return (bool)file;
+}
+
+// Load the cache from <path>. Entries that do not fit within the capacity are dropped.
+bool phys::FEAResultsCache::load() {
+	if (path == "" || !IO::file_exists(path)) return false;
+	ifstream file(path, ios::binary);
+	auto read = [&](void* data, size_t size) { return (bool)file.read((char*)data, size); };
+	char magic[8];
+	uint64_t no_entries;
+	if (!read(magic, sizeof(magic)) || memcmp(magic, FEA_CACHE_MAGIC, sizeof(magic)) || !read(&no_entries, sizeof(no_entries))) {
+		cout << "phys: ERROR: File " << path << " is not an FEA results cache.\n";
+		return false;
+	}
+	for (uint64_t i = 0; i < no_entries && entries.size() < capacity; i++) {
+		Key key;
+		int32_t header[3];
+		if (!read(&key, sizeof(key)) || !read(header, sizeof(header)) || header[1] < 0 || header[2] < 0) return false;
+		FEAResults2D results(header[1], header[2]);
+		uint64_t no_sensitivities;
+		bool success = read(&results.min, sizeof(double)) && read(&results.max, sizeof(double))
+			&& read(results.values.data(), results.values.size() * sizeof(double))
+			&& read(results.valid.data(), results.valid.size())
+			&& read(&no_sensitivities, sizeof(no_sensitivities)) && no_sensitivities <= results.values.size();
+		if (!success) return false;
+		results.sensitivities.resize(no_sensitivities);
+		if (!read(results.sensitivities.data(), no_sensitivities * sizeof(double))) return false;
+		insert(key, &results, header[0]);
+	}
+	return true;
+}
+
+static const char RESULTS_ARCHIVE_MAGIC[8] = { 'F', 'E', 'A', 'A', 'R', 'C', 'H', '1' };
+static const char RESULTS_ARCHIVE_INDEX_MAGIC[8] = { 'F', 'E', 'A', 'I', 'N', 'D', 'X', '1' };
+
+// Append raw bytes or a length-prefixed string to an archive buffer
+static void put_bytes(string& buffer, const void* data, size_t size) { buffer.append((const char*)data, size); }
+static void put_string(string& buffer, const string& text) {
+	uint32_t length = text.size();
+	put_bytes(buffer, &length, sizeof(length));
+	buffer += text;
+}
+
+// Cursor over an archive buffer. Reads fail (rather than overrun) once the end of the buffer is reached.
+struct ArchiveCursor {
+	const char* position;
+	const char* end;
+
+	bool get_bytes(void* data, size_t size) {
+		if (size > (size_t)(end - position)) return false;
+		memcpy(data, position, size);
+		position += size;
+		return true;
+	}
+	bool get_string(string& text) {
+		uint32_t length;
+		if (!get_bytes(&length, sizeof(length)) || length > (size_t)(end - position)) return false;
+		text.assign(position, length);
+		position += length;
+		return true;
+	}
+};
+
+/*
+Create a new archive at <path>, overwriting any existing file. Layout: magic, the number of FEA cases, the case names
+and the mechanical constraint, followed by the records (see append) and, once finished, the index footer (see finish).
+*/
+bool phys::ResultsArchive::create(string _path, vector<string> _case_names, string _mechanical_constraint) {
+	path = _path;
+	case_names = _case_names;
+	mechanical_constraint = _mechanical_constraint;
+	offsets.clear();
+	names.clear();
+	string header;
+	put_bytes(header, RESULTS_ARCHIVE_MAGIC, sizeof(RESULTS_ARCHIVE_MAGIC));
+	uint32_t no_cases = case_names.size();
+	put_bytes(header, &no_cases, sizeof(no_cases));
+	for (auto& case_name : case_names) put_string(header, case_name);
+	put_string(header, mechanical_constraint);
+	ofstream file(path, ios::binary | ios::trunc);
+	file.write(header.data(), header.size());
+	if (!file) {
+		cout << "phys: ERROR: Unable to create results archive " << path << endl;
+		return false;
+	}
+	end = header.size();
+	open_for_writing = true;
+	return true;
+}
+
+/*
+Append a record to the archive. Layout: the size of the remainder of the record, the name, iteration, grid dimensions,
+fitness, min and max, flags, the density words, and the case fields (each prefixed by its number of values).
+*/
+bool phys::ResultsArchive::append(Record* record) {
+	if (!open_for_writing) return false;
+	string buffer;
+	uint64_t record_size = 0;
+	put_bytes(buffer, &record_size, sizeof(record_size));
+	put_string(buffer, record->name);
+	int32_t header[3] = { record->iteration, record->dim_x, record->dim_y };
+	put_bytes(buffer, header, sizeof(header));
+	double statistics[3] = { record->fitness, record->min, record->max };
+	put_bytes(buffer, statistics, sizeof(statistics));
+	uint8_t flags = (uint8_t)record->fitness_is_proxy | ((uint8_t)record->fitness_is_cached << 1);
+	put_bytes(buffer, &flags, sizeof(flags));
+	uint64_t no_words = record->bits.size();
+	put_bytes(buffer, &no_words, sizeof(no_words));
+	put_bytes(buffer, record->bits.data(), no_words * sizeof(uint64_t));
+	uint32_t no_fields = record->case_fields.size();
+	put_bytes(buffer, &no_fields, sizeof(no_fields));
+	for (auto& field : record->case_fields) {
+		uint64_t no_values = field.size();
+		put_bytes(buffer, &no_values, sizeof(no_values));
+		put_bytes(buffer, field.data(), no_values * sizeof(float));
+	}
+	record_size = buffer.size() - sizeof(record_size);
+	memcpy(buffer.data(), &record_size, sizeof(record_size));
+
+	ofstream file(path, ios::binary | ios::app);
+	file.write(buffer.data(), buffer.size());
+	if (!file) {
+		cout << "phys: ERROR: Unable to append record to results archive " << path << endl;
+		return false;
+	}
+	offsets.push_back(end);
+	names.push_back(record->name);
+	end += buffer.size();
+	return true;
+}
+
+// Write the index footer: the offset and name of each record, the number of records, the offset of the index and a magic
+bool phys::ResultsArchive::finish() {
+	if (!open_for_writing) return false;
+	open_for_writing = false;
+	string footer;
+	for (int i = 0; i < offsets.size(); i++) {
+		put_bytes(footer, &offsets[i], sizeof(uint64_t));
+		put_string(footer, names[i]);
+	}
+	uint64_t trailer[2] = { offsets.size(), end };
+	put_bytes(footer, trailer, sizeof(trailer));
+	put_bytes(footer, RESULTS_ARCHIVE_INDEX_MAGIC, sizeof(RESULTS_ARCHIVE_INDEX_MAGIC));
+	ofstream file(path, ios::binary | ios::app);
+	file.write(footer.data(), footer.size());
+	return (bool)file;
+}
+
+// Open an existing archive for reading, obtaining its header and record index
+bool phys::ResultsArchive::open(string _path) {
+	path = _path;
+	open_for_writing = false;
+	offsets.clear();
+	names.clear();
+	case_names.clear();
+	IO::MappedFile file(path);
+	if (file.data == nullptr) {
+		cout << "phys: ERROR: Unable to open results archive " << path << endl;
+		return false;
+	}
+	ArchiveCursor cursor{ file.data, file.data + file.size };
+	char magic[8];
+	uint32_t no_cases;
+	if (!cursor.get_bytes(magic, sizeof(magic)) || memcmp(magic, RESULTS_ARCHIVE_MAGIC, sizeof(magic)) ||
+		!cursor.get_bytes(&no_cases, sizeof(no_cases))
+	) {
+		cout << "phys: ERROR: File " << path << " is not a results archive.\n";
+		return false;
+	}
+	case_names.resize(no_cases);
+	for (auto& case_name : case_names) if (!cursor.get_string(case_name)) return false;
+	if (!cursor.get_string(mechanical_constraint)) return false;
+	const char* records_start = cursor.position;
+
+	// Read the index footer, if the archive was finished
+	uint64_t trailer[2];
+	size_t trailer_size = sizeof(trailer) + sizeof(RESULTS_ARCHIVE_INDEX_MAGIC);
+	if (file.size >= trailer_size + (records_start - file.data) &&
+		!memcmp(file.data + file.size - sizeof(RESULTS_ARCHIVE_INDEX_MAGIC), RESULTS_ARCHIVE_INDEX_MAGIC, sizeof(magic))
+	) {
+		memcpy(trailer, file.data + file.size - trailer_size, sizeof(trailer));
+		ArchiveCursor index{ file.data + trailer[1], file.data + file.size - trailer_size };
+		bool success = trailer[1] <= file.size - trailer_size;
+		for (uint64_t i = 0; success && i < trailer[0]; i++) {
+			uint64_t offset;
+			string name;
+			success = index.get_bytes(&offset, sizeof(offset)) && index.get_string(name);
+			offsets.push_back(offset);
+			names.push_back(name);
+		}
+		if (success) return true;
+		offsets.clear();
+		names.clear();
+	}
+
+	// The archive was not finished, so index it by walking the records. A truncated last record is dropped.
+	cursor.position = records_start;
+	while (cursor.position < cursor.end) {
+		uint64_t offset = cursor.position - file.data;
+		uint64_t record_size;
+		string name;
+		if (!cursor.get_bytes(&record_size, sizeof(record_size)) || record_size > (size_t)(cursor.end - cursor.position)) break;
+		const char* record_end = cursor.position + record_size;
+		if (!cursor.get_string(name)) break;
+		offsets.push_back(offset);
+		names.push_back(name);
+		cursor.position = record_end;
+	}
+	return true;
+}
+
+// Read the i-th record of the archive
+bool phys::ResultsArchive::read(int i, Record& record) const {
+	if (i < 0 || i >= offsets.size()) return false;
+	IO::MappedFile file(path);
+	if (file.data == nullptr || offsets[i] >= file.size) return false;
+	ArchiveCursor cursor{ file.data + offsets[i], file.data + file.size };
+	uint64_t record_size;
+	if (!cursor.get_bytes(&record_size, sizeof(record_size)) || record_size > (size_t)(cursor.end - cursor.position)) return false;
+	cursor.end = cursor.position + record_size;
+	int32_t header[3];
+	double statistics[3];
+	uint8_t flags;
+	uint64_t no_words;
+	uint32_t no_fields;
+	bool success = cursor.get_string(record.name) && cursor.get_bytes(header, sizeof(header))
+		&& cursor.get_bytes(statistics, sizeof(statistics)) && cursor.get_bytes(&flags, sizeof(flags))
+		&& cursor.get_bytes(&no_words, sizeof(no_words)) && no_words <= (cursor.end - cursor.position) / sizeof(uint64_t);
+	if (!success) return false;
+	record.iteration = header[0];
+	record.dim_x = header[1];
+	record.dim_y = header[2];
+	record.fitness = statistics[0];
+	record.min = statistics[1];
+	record.max = statistics[2];
+	record.fitness_is_proxy = flags & 1;
+	record.fitness_is_cached = flags & 2;
+	record.bits.resize(no_words);
+	if (!cursor.get_bytes(record.bits.data(), no_words * sizeof(uint64_t)) || !cursor.get_bytes(&no_fields, sizeof(no_fields))) return false;
+	record.case_fields.resize(no_fields);
+	for (auto& field : record.case_fields) {
+		uint64_t no_values;
+		if (!cursor.get_bytes(&no_values, sizeof(no_values)) || no_values > (cursor.end - cursor.position) / sizeof(float)) return false;
+		field.resize(no_values);
+		cursor.get_bytes(field.data(), no_values * sizeof(float));
+	}
+	return true;
+}
+
+// Get the index of the record with the given name, or -1 if the archive does not contain it
+int phys::ResultsArchive::find(string name) const {
+	auto it = std::find(names.begin(), names.end(), name);
+	return it == names.end() ? -1 : it - names.begin();
+}
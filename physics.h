@@ -2,33 +2,22 @@
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
-#include <vtkActor.h>
-#include <vtkDataSetMapper.h>
-#include <vtkNamedColors.h>
-#include <vtkNew.h>
-#include <vtkProperty.h>
-#include <vtkSmartPointer.h>
-#include <vtkUnstructuredGridReader.h>
-#include <vtkUnstructuredGridWriter.h>
-#include <vtkAutoInit.h>
-#include <vtkTypedDataArray.h>
-#include <vtkTypedDataArrayIterator.h>
-#include <vtkArrayCalculator.h>
-#include <vtkTypeInt64Array.h>
-#include <vtkUnstructuredGrid.h>
-#include <vtkPointData.h>
-#include <vtkFloatArray.h>
-#include <vtkDoubleArray.h>
-#include <vtkPoints.h>
-#include "vtkUnstructuredGridAlgorithm.h"
+#include <array>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <fstream>
+#include <thread>
+#include <chrono>
 #include "helpers.h"
 #include "io.h"
 
 
-//VTK_MODULE_INIT(vtkRenderingOpenGL2)
-//#define VTK_DEBUG_LEAKS true
-
-
 using namespace Eigen;
 
 
@@ -108,6 +97,7 @@ namespace fessga {
             );
             vector<int> get_additional_bound_cells(vector<int>* origin_cells, vector<int>* cells_to_avoid);
             void update_casepaths(string case_folder);
+            string get_results_filename(string case_name);
 
             vector<phys::FEACase> sources, targets, active_cases;
             vector<map<string, vector<Vector2d>>> migration_vectors;
@@ -120,24 +110,205 @@ namespace fessga {
             bool dynamic = false;
             string mechanical_constraint = "";
             int displacement_measurement_cell = -1;
+            string results_format = "vtk"; // Format of Elmer's results files: "vtk" (legacy) or "vtu" (appended raw binary)
+        };
+
+        // Points and layout of the results file of a single FEA run
+        class NodalResults2D {
+        public:
+            NodalResults2D() = default;
+            vector<int> coords; // Node grid index of each point, in the order in which the points appear in the .vtk file
+            string path; // Path of the .vtk file the results were read from
+            size_t point_data_offset = 0; // Byte offset of the point data section (POINT_DATA, or <PointData> for .vtu files)
+            size_t point_data_end = 0; // Byte offset of the end of the <PointData> element (.vtu files only)
+            bool binary = false;
+        };
+
+        // Destination of a point data array read from a results file. Each value is stored in <values> and/or folded into the
+        // running <maxima> and <minima>, all of which are indexed by node of the (dim_x + 1) x (dim_y + 1) node grid.
+        // Of arrays with multiple components, only the first component is used, except for displacements, which are
+        // converted to magnitudes.
+        class NodalArrayTarget {
+        public:
+            string name;
+            double* values = nullptr;
+            double* maxima = nullptr;
+            double* minima = nullptr;
         };
 
+        // Superposition of the nodewise results of all FEA runs of an individual. Per node, the largest tensile and compressive
+        // stress components and the largest displacement magnitude are kept. Runs are folded in while they are read, so
+        // memory use does not depend on the number of FEA cases.
+        class NodalSuperposition2D {
+        public:
+            NodalResults2D layout; // Layout of the first run's file, which is used as the template when writing the superposition
+            vector<double> tensile_xx, tensile_yy, compressive_xx, compressive_yy, displacements;
+
+            // Reset to an empty superposition. Buffers keep their capacity, so no allocations are needed on reuse.
+            void reset(int no_nodes) {
+                layout = NodalResults2D();
+                for (auto* buffer : { &tensile_xx, &tensile_yy, &compressive_xx, &compressive_yy, &displacements }) {
+                    buffer->assign(no_nodes, 0.0);
+                }
+            }
+            bool empty() const { return layout.point_data_offset == 0 || displacements.empty(); }
+        };
+
+        // Reference to the results files of an individual, from which its superposition can be built once it is needed, rather
+        // than keeping the superposition itself
+        class SuperpositionReference {
+        public:
+            vector<string> filenames; // Results file of each FEA case
+            int dim_x = 0, dim_y = 0;
+            Vector2d cell_size, offset;
+            string outfile;
+        };
+
+        // Cellwise FEA results, stored densely (one value per cell of the dim_x x dim_y grid) with a validity mask.
+        // Cells without a valid value read as 0. Copying is a plain copy of the arrays.
         class FEAResults2D {
         public:
             FEAResults2D() = default;
-            FEAResults2D(int dim_x, int dim_y) { x = dim_x, y = dim_y; }
-            PairSet data;
-            map<int, double> data_map;
-            int x, y;
+            FEAResults2D(int dim_x, int dim_y) { reset(dim_x, dim_y); }
+            vector<double> values;
+            vector<uint8_t> valid;
+            int x = 0, y = 0;
             string type;
             double min = INFINITY;
             double max = 0;
+            vector<double> sensitivities; // Cellwise objective sensitivities, only available after in-process FEA
+            vector<vector<float>> case_fields; // Nodal values of the mechanical constraint per FEA run and FE mesh node, only kept if requested when loading
+
+            // Resize to the given grid and mark all cells as not having a value
+            void reset(int dim_x, int dim_y) {
+                x = dim_x, y = dim_y;
+                values.assign(x * y, 0.0);
+                valid.assign(x * y, 0);
+            }
+            void clear() {
+                std::fill(values.begin(), values.end(), 0.0);
+                std::fill(valid.begin(), valid.end(), 0);
+            }
+            void set(int cell, double value) { values[cell] = value; valid[cell] = 1; }
+            double get(int cell) const { return valid[cell] ? values[cell] : 0.0; }
+            bool is_valid(int cell) const { return valid[cell]; }
+
+            // Obtain the valid cells whose value does not exceed <max_value>, ordered by ascending value (ties are ordered by cell index)
+            void get_sorted_cells(vector<int>& cells, double max_value = INFINITY) const {
+                cells.clear();
+                for (int cell = 0; cell < values.size(); cell++) {
+                    if (valid[cell] && values[cell] <= max_value) cells.push_back(cell);
+                }
+                std::sort(cells.begin(), cells.end(), [this](int cell1, int cell2) { return is_lower(cell1, cell2); });
+            }
+
+            // Obtain the (at most) k valid cells with the lowest values, ordered by ascending value, using partial selection
+            void get_lowest_cells(int k, vector<int>& cells) const {
+                cells.clear();
+                for (int cell = 0; cell < values.size(); cell++) if (valid[cell]) cells.push_back(cell);
+                k = std::min(k, (int)cells.size());
+                auto compare = [this](int cell1, int cell2) { return is_lower(cell1, cell2); };
+                std::nth_element(cells.begin(), cells.begin() + k, cells.end(), compare);
+                cells.resize(k);
+                std::sort(cells.begin(), cells.end(), compare);
+            }
+
+        private:
+            bool is_lower(int cell1, int cell2) const {
+                if (values[cell1] != values[cell2]) return values[cell1] < values[cell2];
+                return cell1 < cell2;
+            }
+        };
+
+        // Content-addressed cache of cellwise FEA results. Entries are keyed by a 128-bit hash of a density distribution and the
+        // FEA context (active cases and solver), and are evicted in least-recently-used order once the capacity is reached.
+        // Nodal results are not cached. If a path is given, the cache can be saved to and loaded from disk between runs.
+        class FEAResultsCache {
+        public:
+            struct Key {
+                uint64_t low = 0, high = 0;
+                bool operator==(const Key& other) const { return low == other.low && high == other.high; }
+            };
+            struct KeyHasher {
+                size_t operator()(const Key& key) const { return (size_t)(key.low ^ (key.high * 0x9E3779B97F4A7C15ULL)); }
+            };
+            struct Entry {
+                Key key;
+                FEAResults2D results;
+                int iteration = 0; // Iteration in which the results were computed
+                uint64_t last_use = 0;
+            };
+            FEAResultsCache() = default;
+            FEAResultsCache(int _capacity, string _path = "") : capacity(_capacity), path(_path) {}
+            int capacity = 0; // Maximum number of entries. A capacity of 0 disables the cache.
+            string path;
+            int no_lookups = 0, no_hits = 0;
+
+            void set_context(FEACaseManager* fea_casemanager, string solver);
+            Key get_key(uint* values, int size, int dim_x, int dim_y) const;
+            bool fetch(Key key, FEAResults2D& results);
+            void insert(Key key, FEAResults2D* results, int iteration);
+            float get_hit_rate() const { return no_lookups ? (float)no_hits / (float)no_lookups : 0.0; }
+            void reset_stats() { no_lookups = 0; no_hits = 0; }
+            int size() const { return entries.size(); }
+            bool save() const;
+            bool load();
+        private:
+            Key context;
+            uint64_t clock = 0;
+            vector<Entry> entries;
+            unordered_map<Key, int, KeyHasher> index; // Maps keys to positions in <entries>
+        };
+
+        // Append-only binary archive of the evaluated individuals of a single iteration, which replaces the per-individual folders
+        // as the permanent record of a run. Each record holds an individual's density bits, fitness and the nodal values of
+        // the mechanical constraint of each FEA case. Records are appended as they are obtained; an index of record offsets is
+        // written as a footer once the archive is finished. Archives without a footer (e.g. of an interrupted run) are
+        // indexed by scanning their records.
+        class ResultsArchive {
+        public:
+            struct Record {
+                string name; // Name of the individual's output folder
+                int iteration = 0;
+                int dim_x = 0, dim_y = 0;
+                double fitness = 0, max = 0, min = 0;
+                bool fitness_is_proxy = false, fitness_is_cached = false;
+                vector<uint64_t> bits; // Density values, 64 cells per word
+                vector<vector<float>> case_fields; // Indexed by node of the FE mesh, in the order of msh::FEMesh2D::node_grid_indices
+
+                void set_densities(uint* values, int size) {
+                    bits.assign((size + 63) / 64, 0);
+                    for (int cell = 0; cell < size; cell++) bits[cell >> 6] |= (uint64_t)(values[cell] & 1) << (cell & 63);
+                }
+                bool get_density(int cell) const { return (bits[cell >> 6] >> (cell & 63)) & 1; }
+            };
+            ResultsArchive() = default;
+            string path;
+            string mechanical_constraint;
+            vector<string> case_names;
+            vector<uint64_t> offsets; // Byte offset of each record
+            vector<string> names; // Name of each record
+
+            // Writing
+            bool create(string _path, vector<string> _case_names, string _mechanical_constraint);
+            bool append(Record* record);
+            bool finish();
+            bool is_open() const { return open_for_writing; }
+
+            // Reading
+            bool open(string _path);
+            bool read(int i, Record& record) const;
+            int find(string name) const;
+            int size() const { return offsets.size(); }
+        private:
+            bool open_for_writing = false;
+            uint64_t end = 0; // Byte offset at which the next record is appended
         };
 
         static void start_external_process(
-            string base_folder, vector<FILE*>* pipes = 0, bool wait = true, bool verbose = false
+            string base_folder, vector<FILE*>* pipes = 0, bool wait = true, bool verbose = false, string arguments = ""
         ) {
-            std::string command = base_folder + "/run_elmer.bat";
+            std::string command = base_folder + "/run_elmer.bat" + (arguments.size() ? " " + arguments : "");
             if (wait) {
                 std::array<char, 80> buffer;
                 FILE* pipe = _popen(command.c_str(), "r");
@@ -163,24 +334,76 @@ namespace fessga {
             }
         }
 
+        // Solve a single FEA case in the given folder. The case file is passed to ElmerSolver directly instead of through
+        // ELMERSOLVER_STARTINFO, so several cases of the same folder can be solved concurrently.
+        static void call_elmer_case(string case_folder, string case_name, bool verbose = false) {
+            start_external_process(case_folder, 0, true, verbose, case_name + ".sif");
+        }
+
+        // Policy for retrying FEA solver runs. A run has failed if its results file has not appeared <results_timeout>
+        // seconds after the solver exited. A failed run is repeated after <retry_delay> seconds, up to <max_attempts> runs.
+        struct RetryPolicy {
+            int max_attempts = 2;
+            double retry_delay = 1.0;
+            double results_timeout = 10.0;
+        };
+
+        static bool solve_elmer_case(string case_folder, string case_name, string results_path, RetryPolicy policy, bool verbose = false);
+
+        // Scratch buffers of load_2d_physics_data. Each thread owns one set, which keeps its capacity between loads, so that
+        // loading the results of an individual does not allocate node grid buffers.
+        class NodalLoadBuffers {
+        public:
+            vector<double> nodewise_values;
+            vector<uint8_t> inactive_mask;
+            vector<NodalArrayTarget> targets = { NodalArrayTarget() };
+        };
+
+        // Load the results of the given .vtk files (see load_nodal_results). Each file is parsed once, and its nodal values of the mechanical constraint
+        // are reduced to cellwise values that are folded into <results>, such that each cell retains its maximum value out of
+        // all FEA runs. If <keep_nodal_results> is set and the node grid indices of the FE mesh are given, the nodal values of
+        // each run are kept in results.case_fields (e.g. for archiving), in the order of the FE mesh's nodes. Superpositions are not built here, but from the results files once they are needed (see
+        // SuperpositionReference).
         static bool load_2d_physics_data(
             vector<string> filenames, FEAResults2D& results, FEACaseManager* fea_casemanager, int dim_x, int dim_y, Vector2d cell_size,
-            Vector3d _offset, string mechanical_constraint)
+            Vector3d _offset, string mechanical_constraint, bool keep_nodal_results = false, vector<int>* node_grid_indices = 0)
         {
-            // For each coordinate, retain the maximum value out of all FEA runs
-            // We thereby obtain a superposition of stress distributions.
-            for (auto& filename : filenames) {
-                FEAResults2D single_run_results;
-                load_single_VTK_file(filename, &single_run_results, fea_casemanager, dim_x, dim_y, cell_size, _offset, mechanical_constraint);
-                for (auto& [coord, stress] : single_run_results.data_map) {
-                    if (single_run_results.data_map[coord] > results.data_map[coord]) {
-                        results.data_map[coord] = single_run_results.data_map[coord];
-                    }
+            Vector2d offset = Vector2d(_offset(0), _offset(1));
+            int no_nodes = (dim_x + 1) * (dim_y + 1);
+            if (results.values.size() != dim_x * dim_y) results.reset(dim_x, dim_y);
+            bool keep_case_fields = keep_nodal_results && node_grid_indices != nullptr;
+            results.case_fields.resize(keep_case_fields ? filenames.size() : 0);
+
+            // The nodal values of the mechanical constraint are only needed until the run's cellwise values have been obtained,
+            // so a single buffer is shared by all runs
+            static thread_local NodalLoadBuffers buffers;
+            vector<double>& nodewise_values = buffers.nodewise_values;
+            nodewise_values.resize(no_nodes);
+            buffers.targets[0].name = mechanical_constraint;
+            buffers.targets[0].values = nodewise_values.data();
+
+            // Cells marked as 'inactive' are ignored during solution evaluation
+            buffers.inactive_mask.assign(dim_x * dim_y, 0);
+            for (auto& cell : fea_casemanager->inactive_cells) buffers.inactive_mask[cell] = 1;
+
+            NodalResults2D nodal_results;
+            for (int i = 0; i < filenames.size(); i++) {
+                std::fill(nodewise_values.begin(), nodewise_values.end(), 0.0);
+                bool success = load_nodal_results(
+                    filenames[i], nodal_results, dim_x, dim_y, cell_size, offset, buffers.targets, node_grid_indices
+                );
+                if (!success) {
+                    results.max = INFINITY; // Treat unreadable results as infeasible
+                    return false;
                 }
-                if (single_run_results.max > results.max) results.max = single_run_results.max;
-                if (single_run_results.min < results.min) results.min = single_run_results.min;
+                fold_cellwise_results(
+                    &nodewise_values, &buffers.inactive_mask, &results, fea_casemanager, dim_x, dim_y, mechanical_constraint
+                );
+                if (!keep_case_fields) continue;
+                vector<float>& case_field = results.case_fields[i];
+                case_field.resize(node_grid_indices->size());
+                for (int node = 0; node < case_field.size(); node++) case_field[node] = nodewise_values[node_grid_indices->at(node)];
             }
-            help::sort(results.data_map, results.data);
 
             return true;
         }
@@ -199,211 +422,31 @@ namespace fessga {
             return cell_neighbors;
         }
 
-        static void load_nodewise_results(
-            string filename, double* results_nodewise, int dim_x, int dim_y, Vector2d cell_size,
-            Vector2d offset, string mechanical_constraint, vector<int>* _coords = 0
-        ) {
-            // Read data from file
-            vtkUnstructuredGridReader* reader = vtkUnstructuredGridReader::New();
-            reader->SetFileName(filename.c_str());
-            reader->ReadAllScalarsOn();
-            reader->Update();
-            vtkUnstructuredGrid* output = reader->GetOutput();
-
-            // Get point data (this object contains the physics data)
-            vtkPointData* point_data = output->GetPointData();
-
-            // Obtain stress array(s)
-            //vtkDoubleArray* vonmises = dynamic_cast<vtkDoubleArray*>(point_data->GetScalars("Vonmises"));
-            vtkDoubleArray* results_array = dynamic_cast<vtkDoubleArray*>(point_data->GetScalars(mechanical_constraint.c_str()));
-            if (results_array->GetSize() == 0) return; // If the array is empty, there is no physics data to load.
-
-            // Overwrite grid values with values from results array (only for nodes with coordinates that lie within
-            // the FE mesh)
-            vtkPoints* points = output->GetPoints();
-            double point[2];
-            vector<int> coords;
-            Vector2d inv_cell_size = Vector2d(1.0 / cell_size(0), 1.0 / cell_size(1));
-            for (int i = 0; i < points->GetNumberOfPoints(); i++) {
-                point[0] = points->GetData()->GetTuple(i)[0];
-                point[1] = points->GetData()->GetTuple(i)[1];
-                Vector2d origin_aligned_coord = Vector2d(point[0], point[1]) - offset;
-                Vector2d gridscale_coord = inv_cell_size.cwiseProduct(origin_aligned_coord);
-                int coord = (round(gridscale_coord[0]) * (dim_y + 1) + round(gridscale_coord[1]));
-                if (_coords != 0) _coords->push_back(coord);
-                else coords.push_back(coord);
-                if (mechanical_constraint == "Displacement") {
-                    double displacement_x = (double)results_array->GetValue(i * 3);
-                    double displacement_y = (double)results_array->GetValue(i * 3 + 1);
-                    double magnitude = Vector2d(displacement_x, displacement_y).norm();
-                    magnitude = max(magnitude, 0.0);
-                    results_nodewise[coord] = magnitude;
-                }
-                else {
-                    results_nodewise[coord] = (double)results_array->GetValue(i);
-                }
-            }
-            reader->Delete();
-        }
-
-        static void write_results_superposition(vector<string> vtk_paths, int dim_x, int dim_y, Vector2d cell_size, Vector3d _offset, string outfile, string mechanical_constraint)
-        {
-            // Initially, populate results array with zeroes (nodes on the grid which are part of the FE mesh will
-            // have their corresponding values in the results array overwritten later)
-            double* nodewise_tensile_xx = new double[(dim_x + 1) * (dim_y + 1)];
-            double* nodewise_tensile_yy = new double[(dim_x + 1) * (dim_y + 1)];
-            double* nodewise_compressive_xx = new double[(dim_x + 1) * (dim_y + 1)];
-            double* nodewise_compressive_yy = new double[(dim_x + 1) * (dim_y + 1)];
-            double* nodewise_displacements = new double[(dim_x + 1) * (dim_y + 1)];
-            help::populate_with_zeroes(nodewise_tensile_xx, dim_x + 1, dim_y + 1);
-            help::populate_with_zeroes(nodewise_tensile_yy, dim_x + 1, dim_y + 1);
-            help::populate_with_zeroes(nodewise_compressive_xx, dim_x + 1, dim_y + 1);
-            help::populate_with_zeroes(nodewise_compressive_yy, dim_x + 1, dim_y + 1);
-            help::populate_with_zeroes(nodewise_displacements, dim_x + 1, dim_y + 1);
-            Vector2d offset = Vector2d(_offset(0), _offset(1));
-            for (auto& casepath : vtk_paths) {
-                double* single_run_stress_xx = new double[(dim_x + 1) * (dim_y + 1)]; // Nodes grid has +1 width along each dim
-                double* single_run_stress_yy = new double[(dim_x + 1) * (dim_y + 1)]; // Nodes grid has +1 width along each dim
-                double* single_run_displacements = new double[(dim_x + 1) * (dim_y + 1)]; // Nodes grid has +1 width along each dim
-                help::populate_with_zeroes(single_run_stress_xx, dim_x + 1, dim_y + 1);
-                help::populate_with_zeroes(single_run_stress_yy, dim_x + 1, dim_y + 1);
-                help::populate_with_zeroes(single_run_displacements, dim_x + 1, (dim_y + 1));
-                phys::load_nodewise_results(casepath, single_run_stress_xx, dim_x, dim_y, cell_size, offset, "Stress_xx");
-                phys::load_nodewise_results(casepath, single_run_stress_yy, dim_x, dim_y, cell_size, offset, "Stress_yy");
-                phys::load_nodewise_results(casepath, single_run_displacements, dim_x, dim_y, cell_size, offset, "Displacement");
-                for (int i = 0; i < (dim_x + 1) * (dim_y + 1); i++) {
-                    nodewise_tensile_xx[i] = max(nodewise_tensile_xx[i], single_run_stress_xx[i]);
-                    nodewise_tensile_yy[i] = max(nodewise_tensile_yy[i], single_run_stress_yy[i]);
-                    nodewise_compressive_xx[i] = min(nodewise_compressive_xx[i], single_run_stress_xx[i]);
-                    nodewise_compressive_yy[i] = min(nodewise_compressive_yy[i], single_run_stress_yy[i]);
-                    nodewise_displacements[i] = max(nodewise_displacements[i], single_run_displacements[i]);
-                }
-                delete[] single_run_stress_xx;
-                delete[] single_run_stress_yy;
-                delete[] single_run_displacements;
-            }
-
-            // Read data from file
-            vtkUnstructuredGridReader* reader = vtkUnstructuredGridReader::New();
-            reader->SetFileName(vtk_paths[0].c_str());
-            reader->ReadAllScalarsOn();
-            reader->Update();
-            vtkUnstructuredGrid* output = reader->GetOutput();
-
-            // Get point data (this object contains the physics data)
-            vtkPointData* point_data = output->GetPointData();
-
-            // Obtain Von Mises stress array
-            vtkDoubleArray* stress_xx = dynamic_cast<vtkDoubleArray*>(point_data->GetScalars("Stress_xx"));
-            vtkDoubleArray* stress_yy = dynamic_cast<vtkDoubleArray*>(point_data->GetScalars("Stress_yy"));
-            vtkDoubleArray* displacements = dynamic_cast<vtkDoubleArray*>(point_data->GetScalars("Displacement"));
-            if (displacements->GetSize() == 0) return; // If the array is empty, there is no physics data to load.
-
-            // Overwrite grid values with values from results array (only for nodes with coordinates that lie within
-            // the FE mesh)
-            vtkPoints* points = output->GetPoints();
-            double point[2];
-            vector<int> coords;
-            Vector2d inv_cell_size = Vector2d(1.0 / cell_size(0), 1.0 / cell_size(1));
-            for (int i = 0; i < points->GetNumberOfPoints(); i++) {
-                point[0] = points->GetData()->GetTuple(i)[0];
-                point[1] = points->GetData()->GetTuple(i)[1];
-                Vector2d origin_aligned_coord = Vector2d(point[0], point[1]) - offset;
-                Vector2d gridscale_coord = inv_cell_size.cwiseProduct(origin_aligned_coord);
-                int coord = (round(gridscale_coord[0]) * (dim_y + 1) + round(gridscale_coord[1]));
-                int x = coord / (dim_y + 1);
-                int y = coord % (dim_y + 1);
-                coords.push_back(coord);
-
-                // Accumulate the largest absolute values for stress and displacement
-                if (nodewise_tensile_xx[coord] > -nodewise_compressive_xx[coord]) {
-                    stress_xx->SetValue(i, nodewise_tensile_xx[coord]);
-                }
-                else stress_xx->SetValue(i, nodewise_compressive_xx[coord]);
-                if (nodewise_tensile_yy[coord] > -nodewise_compressive_yy[coord]) {
-                    stress_yy->SetValue(i, nodewise_tensile_yy[coord]);
-                }
-                else stress_yy->SetValue(i, nodewise_compressive_yy[coord]);
-                displacements->SetValue(i * 3 + 2, nodewise_displacements[coord]);
-            }
-
-            // Write to vtk OUTFILE
-            vtkUnstructuredGridWriter* writer = vtkUnstructuredGridWriter::New();
-            writer->SetFileName(outfile.c_str());
-            writer->SetFileTypeToASCII();
-            writer->SetInputData(reader->GetOutput());
-            writer->Update();
-
-            // Delete writer and reader
-            delete[] nodewise_tensile_xx;
-            delete[] nodewise_tensile_yy;
-            delete[] nodewise_compressive_xx;
-            delete[] nodewise_compressive_yy;
-            delete[] nodewise_displacements;
-            writer->Delete();
-
-            return;
-        }
-
-        static bool load_single_VTK_file(
-            string filename, FEAResults2D* results, FEACaseManager* fea_casemanager, int dim_x, int dim_y, Vector2d cell_size,
-            Vector3d _offset, string mechanical_constraint
-        ) {
-            // Read data from file
-            vtkUnstructuredGridReader* reader = vtkUnstructuredGridReader::New();
-            reader->SetFileName(filename.c_str());
-            reader->ReadAllScalarsOn();
-            reader->Update();
-            vtkUnstructuredGrid* output = reader->GetOutput();
-
-            // Initially, populate results array with zeroes (nodes on the grid which are part of the FE mesh will
-            // have their corresponding values in the results array overwritten later)
-            Vector2d offset = Vector2d(_offset(0), _offset(1));
-            double* results_nodewise = new double[(dim_x + 1) * (dim_y + 1)]; // Nodes grid has +1 width along each dim
-            vector<int> coords;
-            help::populate_with_zeroes(results_nodewise, dim_x + 1, dim_y + 1);
-            phys::load_nodewise_results(filename, results_nodewise, dim_x, dim_y, cell_size, offset, mechanical_constraint, &coords);
-
-            // Create cellwise results distribution by taking mean of each group of 4 corners of a cell
-            double min_stress = 1e30;
-            double max_stress = 0;
-            for (int i = 0; i < coords.size(); i++) {
-                int node_coord = coords[i];
-                int x = node_coord / (dim_y + 1);
-                int y = node_coord % (dim_y + 1);
-                if (x == dim_x || y == dim_y) continue; // Skip coordinates outside cell domain
-                int cell_coord = x * dim_y + y;
-                if (help::is_in(&fea_casemanager->inactive_cells, cell_coord)) {
-                    // Cells marked as 'inactive' are ignored during solution evaluation.
-                    results->data_map.insert(pair(cell_coord, -9999));
-                    continue;
-                }
-                if (mechanical_constraint == "Displacement" && cell_coord != fea_casemanager->displacement_measurement_cell) {
-                    continue;
-                }
-                Vector4d neighbors;
-                neighbors[0] = results_nodewise[node_coord];
-                neighbors[1] = results_nodewise[(x + 1) * (dim_y + 1) + y];
-                neighbors[2] = results_nodewise[(x + 1) * (dim_y + 1) + (y + 1)];
-                neighbors[3] = results_nodewise[x * (dim_y + 1) + (y + 1)];
-                if (neighbors.minCoeff() == 0) continue; // Skip cells with corners that have stress value 0
-                double cell_value = neighbors.mean();
-                results->data_map.insert(pair(cell_coord, neighbors.mean()));
-                if (mechanical_constraint == "Displacement") {
-                    max_stress = cell_value;
-                }
-                else {
-                    if (cell_value > max_stress) max_stress = cell_value;
-                    if (cell_value < min_stress) min_stress = cell_value;
-                }
-            }
-            results->min = min_stress;
-            results->max = max_stress;
-            delete[] results_nodewise;
-            reader->Delete();
-
-            return true;
-        }
+        // Read the point arrays of the given targets from a legacy VTK file (ASCII or binary) or a VTU file in a single pass over
+        // the memory-mapped file contents. Values are written to the targets' node-indexed buffers as they are parsed; nodes that
+        // are not part of the FE mesh (and arrays that are missing from the file) leave the buffers untouched.
+        // If the node grid indices of the FE mesh are given (see msh::FEMesh2D), they are used as the points' node indices,
+        // provided that a sample of the point coordinates confirms that Elmer preserved the node order. Otherwise, the node
+        // index of each point is computed from its coordinates.
+        static bool load_nodal_results(
+            string filename, NodalResults2D& nodal_results, int dim_x, int dim_y, Vector2d cell_size, Vector2d offset,
+            vector<NodalArrayTarget>& targets, vector<int>* node_grid_indices = 0
+        );
+
+        // Write the given superposition, using the geometry of the first run's file (which determines the file format).
+        // Per node, the stress components with the largest absolute value and the largest displacement magnitude are written.
+        static bool write_results_superposition(NodalSuperposition2D* superposition, int dim_x, int dim_y, string outfile);
+
+        // Build the superposition of the referenced results files and write it to reference->outfile
+        static bool write_results_superposition(SuperpositionReference* reference);
+
+        // Compute cellwise results from the nodewise results of a single FEA run, and fold them into <results> (each cell
+        // retains the maximum of its current value and the value of this run). The value of a cell is the mean of its 4 corner
+        // nodes; cells with a corner of value 0 (i.e. outside the FE mesh) and cells marked in <inactive_mask> are skipped.
+        static bool fold_cellwise_results(
+            vector<double>* nodewise_values, vector<uint8_t>* inactive_mask, FEAResults2D* results, FEACaseManager* fea_casemanager,
+            int dim_x, int dim_y, string mechanical_constraint
+        );
     };
 }
 
@@ -0,0 +1,264 @@
+#pragma once
+#include "simp.h"
+
+
+void SIMP::export_meta_parameters(vector<string>* _) {
+	vector<string> additional_metaparameters = {
+		"optimizer = SIMP",
+		"initial volume step = " + to_string(volume_step),
+		"minimum volume step = " + to_string(min_volume_step),
+		"penalty = " + to_string(penalty),
+		"filter radius = " + to_string(filter_radius),
+		"move limit = " + to_string(move_limit),
+		"convergence tolerance = " + to_string(convergence_tolerance),
+		"max iterations per volume step = " + to_string(max_iterations_per_volume_step),
+		"stress evaluation = in-process Q4 model (GridSolver2D)",
+		"projections verified with Elmer = " + to_string(verify_with_elmer)
+	};
+	OptimizerBase::export_meta_parameters(&additional_metaparameters);
+}
+
+void SIMP::export_stats(string iteration_name) {
+	if (initialize) IO::write_text_to_file(
+		"Iteration, Iteration time, Relative area, Volume fraction, Volume step, Compliance, Change, Available RAM",
+		statistics_file
+	);
+	stats.push_back(to_string(relative_area));
+	stats.push_back(to_string(volume_fraction));
+	stats.push_back(to_string(volume_step));
+	stats.push_back(to_string(compliance));
+	stats.push_back(to_string(change));
+	export_base_stats();
+	initialize = false;
+}
+
+void SIMP::init_solver() {
+	vector<fem::LoadCase> load_cases;
+	fem::create_load_cases(&fea_casemanager, densities.dim_x, densities.dim_y, densities.cell_size, load_cases);
+	fem::Material material = fem::parse_material(&fea_casemanager.active_cases[0]);
+	solver = fem::GridSolver2D(densities.dim_x, densities.dim_y, densities.cell_size, material, load_cases);
+}
+
+// Compute the (normalized) weights of the density filter. Each cell is given a weighted average of the design
+// variables of the cells within <filter_radius>, with weights decreasing linearly with distance.
+void SIMP::init_filter() {
+	filter_weights = vector<vector<pair<int, double>>>(no_cells);
+	int reach = (int)ceil(filter_radius) - 1;
+	for (int x = 0; x < densities.dim_x; x++) {
+		for (int y = 0; y < densities.dim_y; y++) {
+			int cell = x * densities.dim_y + y;
+			double weight_sum = 0;
+			for (int nx = max(0, x - reach); nx <= min(densities.dim_x - 1, x + reach); nx++) {
+				for (int ny = max(0, y - reach); ny <= min(densities.dim_y - 1, y + reach); ny++) {
+					double weight = filter_radius - sqrt((nx - x) * (nx - x) + (ny - y) * (ny - y));
+					if (weight <= 0) continue;
+					filter_weights[cell].push_back(pair(nx * densities.dim_y + ny, weight));
+					weight_sum += weight;
+				}
+			}
+			for (auto& [neighbor, weight] : filter_weights[cell]) weight /= weight_sum;
+		}
+	}
+}
+
+// Apply the density filter. Passive cells keep their prescribed density.
+void SIMP::apply_filter(vector<double>& input, vector<double>& output) {
+	output.assign(no_cells, 0.0);
+	for (int cell = 0; cell < no_cells; cell++) {
+		if (is_passive[cell]) {
+			output[cell] = is_passive[cell] > 0 ? 1.0 : 0.0;
+			continue;
+		}
+		for (auto& [neighbor, weight] : filter_weights[cell]) output[cell] += weight * input[neighbor];
+	}
+}
+
+// Apply the transpose of the density filter, i.e. map derivatives w.r.t. filtered densities to derivatives w.r.t. the design variables
+void SIMP::apply_filter_transpose(vector<double>& input, vector<double>& output) {
+	output.assign(no_cells, 0.0);
+	for (int cell = 0; cell < no_cells; cell++) {
+		if (is_passive[cell]) continue;
+		for (auto& [neighbor, weight] : filter_weights[cell]) output[neighbor] += weight * input[cell];
+	}
+}
+
+// Compute the compliance of the most recent solve, summed over all load cases, and its derivative w.r.t. the design variables
+double SIMP::get_compliance_sensitivities(vector<double>& sensitivities) {
+	vector<double> filtered_sensitivities(no_cells, 0.0);
+	double _compliance = 0;
+	for (int cell = 0; cell < no_cells; cell++) {
+		double strain_energy = 0;
+		for (int load_case = 0; load_case < solver.load_cases.size(); load_case++) {
+			strain_energy += 2.0 * solver.get_cell_strain_energy(load_case, cell);
+		}
+		double density = filtered_densities[cell];
+		_compliance += (solver.void_stiffness + pow(density, penalty) * (1.0 - solver.void_stiffness)) * strain_energy;
+		filtered_sensitivities[cell] = -penalty * pow(density, penalty - 1.0) * (1.0 - solver.void_stiffness) * strain_energy;
+	}
+	apply_filter_transpose(filtered_sensitivities, sensitivities);
+	return _compliance;
+}
+
+// Optimality criteria update. The Lagrange multiplier of the volume constraint is found by bisection.
+void SIMP::update_design_variables(vector<double>& sensitivities) {
+	// Normalize the sensitivities so that the bisection interval does not depend on the magnitude of the compliance
+	double max_sensitivity = 0;
+	for (auto& sensitivity : sensitivities) max_sensitivity = max(max_sensitivity, abs(sensitivity));
+	if (max_sensitivity == 0) max_sensitivity = 1.0;
+	vector<double> ones(no_cells, 1.0), volume_sensitivities;
+	apply_filter_transpose(ones, volume_sensitivities);
+
+	double target_volume = volume_fraction * (double)no_cells;
+	double lower = 0, upper = 1e9;
+	vector<double> new_variables(no_cells), new_filtered_densities;
+	while ((upper - lower) / (upper + lower) > 1e-4) {
+		double lagrange = 0.5 * (upper + lower);
+		for (int cell = 0; cell < no_cells; cell++) {
+			if (is_passive[cell]) {
+				new_variables[cell] = is_passive[cell] > 0 ? 1.0 : 0.0;
+				continue;
+			}
+			double variable = design_variables[cell];
+			double factor = sqrt(
+				max(0.0, -sensitivities[cell] / max_sensitivity) / (lagrange * max(volume_sensitivities[cell], 1e-12))
+			);
+			new_variables[cell] = min(min(1.0, variable + move_limit), max(max(0.0, variable - move_limit), variable * factor));
+		}
+		apply_filter(new_variables, new_filtered_densities);
+		double volume = 0;
+		for (auto& density : new_filtered_densities) volume += density;
+		if (volume > target_volume) lower = lagrange;
+		else upper = lagrange;
+	}
+	change = 0;
+	for (int cell = 0; cell < no_cells; cell++) change = max(change, abs(new_variables[cell] - design_variables[cell]));
+	design_variables = new_variables;
+}
+
+// Project the filtered densities to a binary distribution with the given volume fraction by filling the cells
+// with the highest filtered densities
+void SIMP::project(float _volume_fraction) {
+	densities.delete_all();
+	vector<int> candidates;
+	for (int cell = 0; cell < no_cells; cell++) {
+		if (is_passive[cell] > 0) densities.fill(cell);
+		else if (!is_passive[cell]) candidates.push_back(cell);
+	}
+	sort(candidates.begin(), candidates.end(), [&](int cell1, int cell2) {
+		return filtered_densities[cell1] > filtered_densities[cell2];
+	});
+	int no_cells_to_fill = min((int)candidates.size(), max(0, (int)round(_volume_fraction * no_cells) - densities.count()));
+	for (int i = 0; i < no_cells_to_fill; i++) densities.fill(candidates[i]);
+	relative_area = (double)densities.count() / (double)no_cells;
+}
+
+// Repair the projected distribution and run FEA on it. Return whether the result is a valid shape that respects the
+// maximum stress threshold according to the in-process model (see also verify_projection).
+bool SIMP::evaluate_projection() {
+	densities.output_folder = iteration_folder;
+	if (!densities.repair()) {
+		cout << "SIMP: Projected density distribution could not be repaired.\n";
+		return false;
+	}
+	if (!solver.solve(&densities)) {
+		cout << "SIMP: ERROR: FEA of projected density distribution failed.\n";
+		return false;
+	}
+	solver.write_results(&densities, fea_casemanager.mechanical_constraint);
+	max_stress = densities.fea_results.max;
+	min_stress = densities.fea_results.min;
+	relative_area = (double)densities.count() / (double)no_cells;
+	cout << "SIMP: Maximum stress of projected distribution (in-process model): " << std::setprecision(3) << std::scientific
+		<< max_stress << endl;
+
+	return max_stress <= fea_casemanager.max_stress_threshold;
+}
+
+/*
+Run FEA with Elmer on the evaluated projection, since the maximum stress threshold was calibrated for Elmer and the stresses
+of the in-process model may differ. Return whether the projection respects the threshold according to Elmer.
+*/
+bool SIMP::verify_projection() {
+	msh::FEMesh2D fe_mesh;
+	msh::create_FE_mesh(mesh, densities, fe_mesh);
+	create_sif_files(&densities, &fe_mesh);
+	msh::export_as_elmer_files(&fe_mesh, iteration_folder);
+	if (export_msh) msh::export_as_msh_file(&fe_mesh, iteration_folder);
+	msh::create_batch_file(iteration_folder);
+	phys::call_elmer(iteration_folder, &fea_casemanager);
+	if (!load_physics(&densities, &mesh, verbose, false, &fe_mesh.node_grid_indices)) {
+		cout << "SIMP: ERROR: FEA of projected density distribution with Elmer failed.\n";
+		return false;
+	}
+	max_stress = densities.fea_results.max;
+	min_stress = densities.fea_results.min;
+	cout << "SIMP: Maximum stress of projected distribution (Elmer): " << std::setprecision(3) << std::scientific
+		<< max_stress << endl;
+
+	return max_stress <= fea_casemanager.max_stress_threshold;
+}
+
+void SIMP::run() {
+	cout << "Beginning SIMP run. Saving results to " << output_folder << endl;
+	export_meta_parameters();
+	init_solver();
+	is_passive = vector<int>(no_cells, 0);
+	for (auto& cell : fea_casemanager.keep_cells) is_passive[cell] = 1;
+	for (auto& cell : fea_casemanager.cutout_cells) is_passive[cell] = -1;
+	init_filter();
+
+	volume_fraction = 1.0 - volume_step;
+	design_variables = vector<double>(no_cells, volume_fraction);
+	for (int cell = 0; cell < no_cells; cell++) if (is_passive[cell]) design_variables[cell] = is_passive[cell] > 0 ? 1.0 : 0.0;
+	float last_valid_volume_fraction = 1.0;
+	string final_valid_iteration_folder = "";
+	int iterations_at_volume_fraction = 0;
+	vector<double> stiffness_factors(no_cells), sensitivities;
+
+	while (iteration_number < max_iterations) {
+		iteration_number++;
+		iterations_at_volume_fraction++;
+		if (verbose) cout << "\nSIMP: Starting iteration " << iteration_number << " (volume fraction " << volume_fraction << ").\n";
+		iteration_folder = get_iteration_folder(iteration_number);
+
+		// Solve for the current continuous densities and update the design variables
+		apply_filter(design_variables, filtered_densities);
+		for (int cell = 0; cell < no_cells; cell++) {
+			stiffness_factors[cell] = solver.void_stiffness + pow(filtered_densities[cell], penalty) * (1.0 - solver.void_stiffness);
+		}
+		if (!solver.solve(&stiffness_factors)) {
+			cout << "SIMP: ERROR: FEA failed.\n";
+			break;
+		}
+		compliance = get_compliance_sensitivities(sensitivities);
+		update_design_variables(sensitivities);
+		apply_filter(design_variables, filtered_densities);
+		project(volume_fraction);
+		export_stats(iteration_name);
+		if (change > convergence_tolerance && iterations_at_volume_fraction < max_iterations_per_volume_step) continue;
+
+		// The continuous design has converged for the current volume fraction. Evaluate its binary projection.
+		cout << "SIMP: Design converged for volume fraction " << volume_fraction << " after " << iterations_at_volume_fraction
+			<< " iterations.\n";
+		iterations_at_volume_fraction = 0;
+		if (evaluate_projection() && (!verify_with_elmer || verify_projection())) {
+			densities.do_export(iteration_folder + "/distribution2d.dens");
+			final_valid_iteration_folder = iteration_folder;
+			last_valid_volume_fraction = volume_fraction;
+			cout << "SIMP: Projected distribution is valid. Exported it to " << iteration_folder << endl;
+		}
+		else if (volume_step / 2.0 >= min_volume_step) {
+			volume_step /= 2.0;
+			volume_fraction = last_valid_volume_fraction;
+			cout << "SIMP: Projected distribution is invalid. Reducing volume step to " << volume_step << endl;
+		}
+		else break;
+		volume_fraction -= volume_step;
+		if (volume_fraction <= volume_step) break;
+	}
+
+	if (final_valid_iteration_folder == "") cout << "\nTerminating SIMP algorithm after " << iteration_number
+		<< " iterations without having found a valid density distribution.\n";
+	else cout << "\nTerminating SIMP algorithm after " << iteration_number << " iterations. Final results were saved to "
+		<< final_valid_iteration_folder << endl;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <Eigen/Core>
+#include <algorithm>
+#include <map>
+#include "helpers.h"
+#include "optimizerBase.h"
+#include "fem.h"
+
+
+/*
+Gradient-based topology optimization using Solid Isotropic Material with Penalization (SIMP).
+Compliance is minimized for a target volume fraction using continuous densities, a density filter and optimality
+criteria updates. Each time the continuous design has converged, it is projected to a binary distribution, which is
+repaired and evaluated. As long as the binary distribution respects the maximum stress threshold, the target volume
+fraction is lowered by the current volume step. If the threshold is exceeded, the volume step is halved (comparable
+to the reduction of greediness in FESS) until it drops below the minimum volume step. Since the threshold is calibrated
+for Elmer, projections that pass the in-process check are verified with Elmer before they are accepted.
+*/
+class SIMP : public OptimizerBase {
+public:
+	SIMP() = default;
+	SIMP(
+		phys::FEACaseManager fea_casemanager, msh::SurfaceMesh mesh, string base_folder, grd::Densities2d _densities,
+		int max_iterations, float _volume_step = 0.05, double _penalty = 3.0, double _filter_radius = 1.5,
+		double _move_limit = 0.2, double _convergence_tolerance = 0.01, bool export_msh = false, bool verbose = true
+	) : OptimizerBase(fea_casemanager, mesh, base_folder, _densities, max_iterations, export_msh, verbose)
+	{
+		volume_step = _volume_step;
+		penalty = _penalty;
+		filter_radius = _filter_radius;
+		move_limit = _move_limit;
+		convergence_tolerance = _convergence_tolerance;
+	}
+	float volume_step = 0.05;
+	float min_volume_step = 0.005;
+	double penalty = 3.0;
+	double filter_radius = 1.5; // In cells
+	double move_limit = 0.2;
+	double convergence_tolerance = 0.01; // Maximum change of a design variable at which the design is considered converged
+	int max_iterations_per_volume_step = 50;
+	float volume_fraction = 1.0;
+	double compliance = 0;
+	double change = 1.0;
+	double relative_area = 1.0;
+	vector<double> design_variables, filtered_densities;
+	vector<int> is_passive; // 1 for keep cells, -1 for cutout cells, 0 otherwise
+	vector<vector<pair<int, double>>> filter_weights; // Normalized filter weights of the neighbors of each cell
+	fem::GridSolver2D solver;
+	bool verify_with_elmer = true; // Only accept projections that also respect the maximum stress threshold according to Elmer
+
+	void run();
+	void init_solver();
+	void init_filter();
+	void apply_filter(vector<double>& input, vector<double>& output);
+	void apply_filter_transpose(vector<double>& input, vector<double>& output);
+	double get_compliance_sensitivities(vector<double>& sensitivities);
+	void update_design_variables(vector<double>& sensitivities);
+	void project(float _volume_fraction);
+	bool evaluate_projection();
+	bool verify_projection();
+	void export_stats(string iteration_name);
+	void export_meta_parameters(vector<string>* _ = 0);
+};
@@ -47,6 +47,22 @@ void Tester::run_tests() {
     successes += _success;
     failures += !_success;
 
+    _success = test_island_migration();
+    successes += _success;
+    failures += !_success;
+
+    _success = test_crossover_operators();
+    successes += _success;
+    failures += !_success;
+
+    _success = test_population_diversity();
+    successes += _success;
+    failures += !_success;
+
+    _success = test_low_rank_update();
+    successes += _success;
+    failures += !_success;
+
     cout << "ALL TESTS FINISHED. " << successes << " / " << (failures + successes) << " tests passed.\n";
 }
 
@@ -467,6 +483,64 @@ bool Tester::test_image_loader() {
     return success;
 }
 
+// Test migration between islands on localhost
+bool Tester::test_island_migration() {
+    bool success = true;
+    success = success && do_island_migration_test("distribution2d", "../data/unit_tests/distribution2d_single_piece.dens", 2, 50100);
+    success = success && do_island_migration_test("distribution2d", "../data/unit_tests/distribution2d_single_piece.dens", 4, 50200);
+
+    cout << "\nTESTING: IslandChannel migration. Test " << (success ? "passed." : "failed.") << "\n\n";
+
+    return success;
+}
+
+/*
+Connect a ring of islands on localhost and let each island send a migrant to the next island. The migrant of island i has
+fitness i, and the given density distribution with cell i flipped. Check that each island receives its predecessor's
+migrant intact.
+*/
+bool Tester::do_island_migration_test(string type, string path, int no_islands, int base_port, bool verbose) {
+    OptimizerBase optimizer = do_setup(type, path);
+    grd::Densities2d* densities = &optimizer.densities;
+
+    // Each island connects to its successor and then waits for its predecessor, so the islands are opened concurrently
+    vector<shared_ptr<IslandChannel>> channels;
+    vector<thread> threads;
+    vector<int> opened(no_islands, 0);
+    for (int i = 0; i < no_islands; i++) channels.push_back(make_shared<IslandChannel>());
+    for (int i = 0; i < no_islands; i++) {
+        threads.push_back(thread([&, i] { opened[i] = channels[i]->open(i, no_islands, base_port, {}, 30); }));
+    }
+    for (auto& _thread : threads) _thread.join();
+    bool success = count(opened.begin(), opened.end(), 1) == no_islands;
+
+    for (int i = 0; success && i < no_islands; i++) {
+        Migrant migrant;
+        migrant.dim_x = densities->dim_x;
+        migrant.dim_y = densities->dim_y;
+        migrant.fitness = i;
+        migrant.set_densities(densities->get_values(), densities->size);
+        migrant.bits[i >> 6] ^= (uint64_t)1 << (i & 63);
+        vector<Migrant> migrants = { migrant };
+        success = channels[i]->send(&migrants);
+    }
+    for (int i = 0; success && i < no_islands; i++) {
+        vector<Migrant> migrants;
+        int predecessor = (i + no_islands - 1) % no_islands;
+        success = channels[i]->receive(migrants, 30) && migrants.size() == 1 && migrants[0].fitness == predecessor;
+        success = success && migrants[0].dim_x == densities->dim_x && migrants[0].dim_y == densities->dim_y;
+        for (int cell = 0; success && cell < densities->size; cell++) {
+            success = migrants[0].get_density(cell) == ((bool)densities->at(cell) != (cell == predecessor));
+        }
+        if (verbose) cout << "Island " << i << (success ? " received" : " did not receive") << " the migrant of island " << predecessor << endl;
+    }
+
+    // Teardown
+    do_teardown();
+
+    return success;
+}
+
 /*
 Create 2 parent slices from the 3d binary density distribution for 2d test
 */
@@ -513,6 +587,132 @@ bool Tester::test_2x_crossover() {
     return true;
 }
 
+// Test the mask-based crossover operators
+bool Tester::test_crossover_operators() {
+    bool success = true;
+    for (string crossover_method : { "2x", "ux", "block", "spatial" }) {
+        success = success && do_crossover_test("distribution2d", "../data/unit_tests/distribution2d_single_piece.dens", crossover_method);
+    }
+
+    cout << "\nTESTING: Crossover operators. Test " << (success ? "passed." : "failed.") << "\n\n";
+
+    return success;
+}
+
+/*
+Cross the given density distribution with its inverse. Every cell of each child should come from one parent, and the two
+children should take complementary cells, so that the children are each other's inverse and their counts add up to the
+grid size.
+*/
+bool Tester::do_crossover_test(string type, string path, string crossover_method, bool verbose) {
+    Evolver evolver = do_evolver_setup(type, path);
+    evo::Individual2d parent1(&evolver.densities), parent2(&evolver.densities);
+    for (int cell = 0; cell < parent2.size; cell++) parent2.set(cell, !parent2[cell]);
+    parent2.update_count();
+    evo::Individual2d child1(&evolver.densities), child2(&evolver.densities);
+    if (crossover_method == "2x") evolver.do_2x_crossover(parent1, parent2, child1, child2);
+    else if (crossover_method == "ux") evolver.do_ux_crossover(parent1, parent2, child1, child2);
+    else if (crossover_method == "block") evolver.do_block_crossover(parent1, parent2, child1, child2);
+    else if (crossover_method == "spatial") evolver.do_spatial_crossover(parent1, parent2, child1, child2);
+
+    bool success = child1.count() + child2.count() == evolver.densities.size;
+    for (int cell = 0; success && cell < evolver.densities.size; cell++) success = child1[cell] != child2[cell];
+    if (verbose) {
+        cout << "\nChild 1 (" << crossover_method << "): \n";
+        child1.print();
+    }
+
+    // Teardown
+    for (auto* individual : { &parent1, &parent2, &child1, &child2 }) individual->delete_arrays();
+    do_teardown();
+
+    return success;
+}
+
+// Test the packed population distances and consensus frequencies
+bool Tester::test_population_diversity() {
+    bool success = true;
+    success = success && do_population_diversity_test("distribution2d", "../data/unit_tests/distribution2d_single_piece.dens", 2);
+    success = success && do_population_diversity_test("distribution2d", "../data/unit_tests/distribution2d_single_piece.dens", 12);
+
+    cout << "\nTESTING: Population diversity. Test " << (success ? "passed." : "failed.") << "\n\n";
+
+    return success;
+}
+
+/*
+Create a population of copies of the given density distribution in which individual i has cells i, 2i, 3i, ... flipped.
+Check the packed distances and consensus frequencies against a cell-by-cell comparison.
+*/
+bool Tester::do_population_diversity_test(string type, string path, int pop_size, bool verbose) {
+    Evolver evolver = do_evolver_setup(type, path);
+    vector<evo::Individual2d> population;
+    for (int i = 0; i < pop_size; i++) {
+        evo::Individual2d individual(&evolver.densities);
+        for (int cell = i + 1; cell < individual.size; cell += i + 1) individual.set(cell, !individual[cell]);
+        individual.update_count();
+        population.push_back(individual);
+    }
+    PackedPopulation packed_population(&population);
+    vector<vector<int>> distances = packed_population.get_distance_matrix();
+    vector<float> frequencies = packed_population.get_consensus_frequencies();
+
+    bool success = packed_population.size() == pop_size;
+    for (int i = 0; success && i < pop_size; i++) {
+        success = packed_population.get_count(i) == population[i].count();
+        for (int j = 0; success && j < pop_size; j++) {
+            int distance = 0;
+            for (int cell = 0; cell < population[i].size; cell++) distance += population[i][cell] != population[j][cell];
+            success = distances[i][j] == distance;
+            if (verbose) cout << "Distance " << i << " - " << j << ": " << distances[i][j] << " (expected " << distance << ")\n";
+        }
+    }
+    for (int cell = 0; success && cell < evolver.densities.size; cell++) {
+        int no_filled = 0;
+        for (auto& individual : population) no_filled += individual[cell];
+        success = abs(frequencies[cell] - (float)no_filled / (float)pop_size) < 1e-6;
+    }
+
+    // Teardown
+    for (auto& individual : population) individual.delete_arrays();
+    do_teardown();
+
+    return success;
+}
+
+/*
+Test the low-rank (Woodbury) update of fem::GridSolver2D. A cantilever is solved, cells are removed in two successive
+steps, and the incrementally updated displacements are compared with those of a fresh factorization.
+*/
+bool Tester::test_low_rank_update() {
+    int dim_x = 20, dim_y = 10;
+    fem::LoadCase load_case;
+    load_case.name = "cantilever";
+    for (int y = 0; y <= dim_y; y++) load_case.fixed_dofs.insert(load_case.fixed_dofs.end(), { y * 2, y * 2 + 1 });
+    load_case.nodal_forces[(dim_x * (dim_y + 1) + dim_y / 2) * 2 + 1] = -1.0;
+    fem::GridSolver2D solver(dim_x, dim_y, Vector2d(1, 1), fem::Material(), { load_case });
+    solver.max_update_rank = 200;
+    vector<double> stiffness_factors(dim_x * dim_y, 1.0);
+    bool success = solver.solve(&stiffness_factors);
+
+    vector<vector<int>> removal_steps = { { 45, 46, 47, 65, 66, 67 }, { 125, 126, 145, 146, 147 } };
+    for (auto& removed_cells : removal_steps) {
+        for (auto& cell : removed_cells) stiffness_factors[cell] = solver.void_stiffness;
+        success = success && solver.solve(&stiffness_factors, true) && solver.last_solve_was_incremental;
+        fem::GridSolver2D reference_solver(dim_x, dim_y, Vector2d(1, 1), fem::Material(), { load_case });
+        success = success && reference_solver.solve(&stiffness_factors);
+        if (!success) break;
+        double error = (solver.displacements[0] - reference_solver.displacements[0]).norm();
+        success = error <= 1e-8 * reference_solver.displacements[0].norm();
+        cout << "Low-rank update of rank " << solver.last_update_rank << ": relative error " << std::scientific
+            << error / reference_solver.displacements[0].norm() << endl;
+    }
+
+    cout << "\nTESTING: Low-rank update of in-process FEA. Test " << (success ? "passed." : "failed.") << "\n\n";
+
+    return success;
+}
+
 bool Tester::test_evolution() {
     Evolver evolver = Evolver();
 
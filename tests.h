@@ -20,8 +20,14 @@ public:
     bool do_individual_repair_test(string type, string path, bool verbose = false);
     bool do_individual_init_population_test(string type, string path, bool verbose = false);
     bool do_individual_image_loader_test(string type, string path, bool verbose = true);
+    bool do_island_migration_test(string type, string path, int no_islands, int base_port, bool verbose = false);
     void create_parents(grd::Densities2d parent1, grd::Densities2d parent2);
     bool test_2x_crossover();
+    bool test_crossover_operators();
+    bool do_crossover_test(string type, string path, string crossover_method, bool verbose = false);
+    bool test_population_diversity();
+    bool test_low_rank_update();
+    bool do_population_diversity_test(string type, string path, int pop_size, bool verbose = false);
     bool test_evolution();
     bool test_init_pieces();
     bool test_remove_smaller_pieces();
@@ -32,6 +38,7 @@ public:
     bool test_repair();
     bool test_init_population();
     bool test_image_loader();
+    bool test_island_migration();
     void do_teardown();
     OptimizerBase do_setup(
         string type, string path, bool verbose = false, int dim_x = -1, int dim_y = -1, string base_folder = ""
@@ -0,0 +1,97 @@
+#pragma once
+#include "workers.h"
+
+
+thread_local WorkerPool* WorkerPool::current_pool = nullptr;
+thread_local int WorkerPool::current_worker = -1;
+
+WorkerPool::WorkerPool(int no_workers) {
+	if (no_workers <= 0) no_workers = max(1u, thread::hardware_concurrency());
+	for (int i = 0; i < no_workers; i++) queues.push_back(make_unique<TaskQueue>());
+	for (int i = 0; i < no_workers; i++) workers.push_back(thread(&WorkerPool::work, this, i));
+}
+
+// Finish all queued tasks and stop the workers
+WorkerPool::~WorkerPool() {
+	{
+		lock_guard<mutex> lock(idle_mutex);
+		stopping = true;
+	}
+	idle_condition.notify_all();
+	for (auto& worker : workers) worker.join();
+}
+
+void WorkerPool::submit(function<void()> task) {
+	int queue = (current_pool == this) ? current_worker : next_queue++ % queues.size();
+	no_unfinished++;
+	{
+		lock_guard<mutex> lock(queues[queue]->queue_mutex);
+		queues[queue]->tasks.push_back(move(task));
+	}
+	no_queued++;
+	{
+		lock_guard<mutex> lock(idle_mutex);
+	}
+	idle_condition.notify_one();
+}
+
+// Block until all submitted tasks (including tasks submitted by other tasks) have finished
+void WorkerPool::wait() {
+	unique_lock<mutex> lock(idle_mutex);
+	done_condition.wait(lock, [this] { return no_unfinished == 0; });
+}
+
+// Block until all submitted tasks have finished or the given number of seconds has passed. Return whether all tasks finished.
+bool WorkerPool::wait_for(double seconds) {
+	unique_lock<mutex> lock(idle_mutex);
+	return done_condition.wait_for(lock, chrono::duration<double>(seconds), [this] { return no_unfinished == 0; });
+}
+
+// Take a task from the back of the given worker's own queue, or else steal one from the front of another worker's queue
+bool WorkerPool::take(int worker, function<void()>& task) {
+	for (int i = 0; i < queues.size(); i++) {
+		TaskQueue* queue = queues[(worker + i) % queues.size()].get();
+		lock_guard<mutex> lock(queue->queue_mutex);
+		if (queue->tasks.empty()) continue;
+		if (i == 0) {
+			task = move(queue->tasks.back());
+			queue->tasks.pop_back();
+		}
+		else {
+			task = move(queue->tasks.front());
+			queue->tasks.pop_front();
+		}
+		no_queued--;
+		return true;
+	}
+	return false;
+}
+
+void WorkerPool::work(int worker) {
+	current_pool = this;
+	current_worker = worker;
+	while (true) {
+		function<void()> task;
+		if (take(worker, task)) {
+			// Tasks are expected to handle their own errors. An exception that escapes is reported rather than terminating
+			// the process, so that the pool's count of unfinished tasks stays correct.
+			try {
+				task();
+			}
+			catch (const exception& e) {
+				cout << "WorkerPool: ERROR: Uncaught exception in task: " << e.what() << endl;
+			}
+			catch (...) {
+				cout << "WorkerPool: ERROR: Uncaught exception in task.\n";
+			}
+			if (--no_unfinished == 0) {
+				lock_guard<mutex> lock(idle_mutex);
+				done_condition.notify_all();
+			}
+			continue;
+		}
+		unique_lock<mutex> lock(idle_mutex);
+		idle_condition.wait(lock, [this] { return stopping || no_queued > 0; });
+		if (stopping && no_queued == 0) return;
+	}
+}
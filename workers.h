@@ -0,0 +1,130 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+
+/*
+Persistent pool of worker threads with work stealing. Each worker has its own task queue. Tasks submitted by a worker
+are pushed onto that worker's queue, and other tasks are distributed over the queues round-robin. A worker takes tasks
+from the back of its own queue, and once that is empty, steals from the front of the queues of the other workers.
+The number of workers defaults to the number of hardware threads.
+*/
+class WorkerPool {
+public:
+	WorkerPool(int no_workers = 0);
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	void submit(function<void()> task);
+	void wait();
+	bool wait_for(double seconds);
+	int size() const { return workers.size(); }
+	int no_pending() const { return no_unfinished; }
+private:
+	struct TaskQueue {
+		mutex queue_mutex;
+		deque<function<void()>> tasks;
+	};
+	bool take(int worker, function<void()>& task);
+	void work(int worker);
+	vector<unique_ptr<TaskQueue>> queues;
+	vector<thread> workers;
+	mutex idle_mutex;
+	condition_variable idle_condition; // Signals workers that tasks were queued (or that the pool is stopping)
+	condition_variable done_condition; // Signals wait() that all tasks have finished
+	atomic<int> no_queued = 0;
+	atomic<int> no_unfinished = 0;
+	atomic<unsigned int> next_queue = 0;
+	bool stopping = false;
+	static thread_local WorkerPool* current_pool;
+	static thread_local int current_worker;
+};
+
+/*
+Counting semaphore that limits the number of concurrently running external processes (such as solver runs), independently
+of the number of worker threads. A Slot holds one of the <capacity> places for as long as it exists.
+*/
+class ProcessLimiter {
+public:
+	class Slot {
+	public:
+		Slot(ProcessLimiter* _limiter) : limiter(_limiter) { limiter->acquire(); }
+		~Slot() { limiter->release(); }
+		Slot(const Slot&) = delete;
+		Slot& operator=(const Slot&) = delete;
+	private:
+		ProcessLimiter* limiter;
+	};
+	void set_capacity(int _capacity) {
+		{
+			lock_guard<mutex> lock(limiter_mutex);
+			capacity = max(1, _capacity);
+		}
+		limiter_condition.notify_all();
+	}
+	int get_capacity() {
+		lock_guard<mutex> lock(limiter_mutex);
+		return capacity;
+	}
+	void acquire() {
+		unique_lock<mutex> lock(limiter_mutex);
+		limiter_condition.wait(lock, [this] { return no_running < capacity; });
+		no_running++;
+	}
+	void release() {
+		{
+			lock_guard<mutex> lock(limiter_mutex);
+			no_running--;
+		}
+		limiter_condition.notify_one();
+	}
+private:
+	mutex limiter_mutex;
+	condition_variable limiter_condition;
+	int capacity = 1;
+	int no_running = 0;
+};
+
+/*
+Queue through which worker threads report completed work items (e.g. the index of an evaluated individual) to a consumer
+thread. pop() blocks until an item is available.
+*/
+template <typename T>
+class CompletionQueue {
+public:
+	void push(T item) {
+		{
+			lock_guard<mutex> lock(queue_mutex);
+			items.push_back(item);
+		}
+		queue_condition.notify_one();
+	}
+	T pop() {
+		unique_lock<mutex> lock(queue_mutex);
+		queue_condition.wait(lock, [this] { return !items.empty(); });
+		T item = items.front();
+		items.pop_front();
+		return item;
+	}
+	bool try_pop(T& item) {
+		lock_guard<mutex> lock(queue_mutex);
+		if (items.empty()) return false;
+		item = items.front();
+		items.pop_front();
+		return true;
+	}
+private:
+	deque<T> items;
+	mutex queue_mutex;
+	condition_variable queue_condition;
+};